@@ -68,6 +68,7 @@ WZ_DECL_NONNULL(1) int wzThreadJoin(WZ_THREAD *thread);
 WZ_DECL_NONNULL(1) void wzThreadDetach(WZ_THREAD *thread);
 WZ_DECL_NONNULL(1) void wzThreadStart(WZ_THREAD *thread);
 void wzYieldCurrentThread();
+int wzGetCPUCount();  ///< Number of logical CPU cores.
 WZ_MUTEX *wzMutexCreate();
 WZ_DECL_NONNULL(1) void wzMutexDestroy(WZ_MUTEX *mutex);
 WZ_DECL_NONNULL(1) void wzMutexLock(WZ_MUTEX *mutex);
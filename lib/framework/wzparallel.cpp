@@ -0,0 +1,168 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2016  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  A pool of worker threads, for splitting loops of the game update between CPU cores.
+ */
+
+#include "frame.h"
+#include "math_ext.h"
+#include "wzapp.h"
+#include "wzparallel.h"
+#include "wzprofile.h"
+
+#include <vector>
+
+typedef std::function<void (unsigned begin, unsigned end, unsigned thread)> ParallelFunc;
+
+static std::vector<WZ_THREAD *> parallelThreads;
+static WZ_MUTEX         *parallelMutex = NULL;          ///< Protects parallelNext.
+static WZ_SEMAPHORE     *parallelStartSemaphore = NULL;  ///< Posted once per worker thread, to start a wzParallelFor.
+static WZ_SEMAPHORE     *parallelDoneSemaphore = NULL;   ///< Posted by each worker thread, when there is nothing left to do.
+static bool             parallelQuit = false;
+static bool             parallelRunning = false;
+
+// The current wzParallelFor. Only changed while the worker threads are waiting for parallelStartSemaphore.
+static ParallelFunc const *parallelFunc = NULL;
+static unsigned         parallelCount = 0;
+static unsigned         parallelChunk = 1;
+static unsigned         parallelNext = 0;
+
+/// Calls parallelFunc on chunks of the range, until there are none left.
+static void parallelWork(unsigned thread)
+{
+	for (;;)
+	{
+		wzMutexLock(parallelMutex);
+		unsigned begin = parallelNext;
+		unsigned end = std::min(begin + parallelChunk, parallelCount);
+		parallelNext = end;
+		wzMutexUnlock(parallelMutex);
+
+		if (begin >= end)
+		{
+			return;
+		}
+		(*parallelFunc)(begin, end, thread);
+	}
+}
+
+/** This runs in separate threads */
+static int parallelThreadFunc(void *data)
+{
+	unsigned thread = (uintptr_t)data;
+
+	wzProfileThreadName("parallel");
+	for (;;)
+	{
+		wzSemaphoreWait(parallelStartSemaphore);  // Go to sleep until needed.
+		if (parallelQuit)
+		{
+			break;
+		}
+		parallelWork(thread);
+		wzSemaphorePost(parallelDoneSemaphore);
+	}
+	return 0;
+}
+
+void wzParallelInit(int numThreads)
+{
+	ASSERT_OR_RETURN(, parallelThreads.empty(), "Already initialised");
+
+	if (numThreads <= 0)
+	{
+		numThreads = wzGetCPUCount() - 1;  // The main thread does its share of the work too.
+	}
+	numThreads = clip(numThreads, 0, 64);
+	debug(LOG_WZ, "Using %d worker threads", numThreads);
+
+	parallelQuit = false;
+	parallelMutex = wzMutexCreate();
+	parallelStartSemaphore = wzSemaphoreCreate(0);
+	parallelDoneSemaphore = wzSemaphoreCreate(0);
+	for (int i = 0; i < numThreads; ++i)
+	{
+		parallelThreads.push_back(wzThreadCreate(parallelThreadFunc, (void *)(uintptr_t)(i + 1)));  // Thread 0 is the main thread.
+		wzThreadStart(parallelThreads.back());
+	}
+}
+
+void wzParallelShutdown()
+{
+	if (parallelMutex == NULL)
+	{
+		return;
+	}
+
+	parallelQuit = true;
+	for (unsigned i = 0; i < parallelThreads.size(); ++i)
+	{
+		wzSemaphorePost(parallelStartSemaphore);  // Wake up threads.
+	}
+	for (unsigned i = 0; i < parallelThreads.size(); ++i)
+	{
+		wzThreadJoin(parallelThreads[i]);
+	}
+	parallelThreads.clear();
+	wzMutexDestroy(parallelMutex);
+	parallelMutex = NULL;
+	wzSemaphoreDestroy(parallelStartSemaphore);
+	parallelStartSemaphore = NULL;
+	wzSemaphoreDestroy(parallelDoneSemaphore);
+	parallelDoneSemaphore = NULL;
+}
+
+unsigned wzParallelThreadCount()
+{
+	return parallelThreads.size() + 1;
+}
+
+void wzParallelFor(unsigned count, ParallelFunc const &func)
+{
+	ASSERT_OR_RETURN(, !parallelRunning, "wzParallelFor called from inside wzParallelFor");
+
+	unsigned numWorkers = std::min<unsigned>(parallelThreads.size(), count - std::min(count, 1u));
+	if (numWorkers == 0)
+	{
+		if (count > 0)
+		{
+			func(0, count, 0);
+		}
+		return;
+	}
+
+	parallelRunning = true;
+	parallelFunc = &func;
+	parallelCount = count;
+	parallelChunk = std::max(count / ((numWorkers + 1) * 4), 1u);  // Small enough chunks that no thread is left with a lot to do at the end.
+	parallelNext = 0;
+
+	for (unsigned i = 0; i < numWorkers; ++i)
+	{
+		wzSemaphorePost(parallelStartSemaphore);
+	}
+	parallelWork(0);
+	for (unsigned i = 0; i < numWorkers; ++i)
+	{
+		wzSemaphoreWait(parallelDoneSemaphore);
+	}
+
+	parallelFunc = NULL;
+	parallelRunning = false;
+}
@@ -0,0 +1,47 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2016  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  A pool of worker threads, for splitting loops of the game update between CPU cores.
+ *
+ *  The items of a loop are handed out to the threads in no particular order, so for the game to stay
+ *  synchronised, each item must only write to its own results, which are then used by the calling thread
+ *  in a fixed order.
+ */
+
+#ifndef _wzparallel_h
+#define _wzparallel_h
+
+#include "wzglobal.h"
+#include "types.h"
+
+#include <functional>
+
+/// Starts the worker threads. If numThreads <= 0, uses one less than the number of CPU cores.
+void wzParallelInit(int numThreads);
+/// Stops the worker threads.
+void wzParallelShutdown();
+/// Number of threads running a wzParallelFor, including the calling thread.
+unsigned wzParallelThreadCount();
+
+/// Calls func(begin, end, thread) on ranges covering [0, count), in the calling thread and in the worker threads, and returns when all are done.
+/// The thread number is less than wzParallelThreadCount(), and is not used by two ranges at once, so can be used to pick a scratch buffer.
+/// Must only be called from the main thread, and not from inside another wzParallelFor.
+void wzParallelFor(unsigned count, std::function<void (unsigned begin, unsigned end, unsigned thread)> const &func);
+
+#endif // _wzparallel_h
@@ -0,0 +1,177 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2016  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Pools of fixed size memory blocks, for objects which are created and destroyed often, such as game objects.
+ */
+
+#include "frame.h"
+#include "wzpool.h"
+
+#include <new>
+
+// With AddressSanitizer, give each object its own heap block, so that uses of freed objects are reported, instead of hiding in the free list.
+#if defined(__SANITIZE_ADDRESS__)
+# define WZ_POOL_USE_HEAP
+#elif defined(__has_feature)
+# if __has_feature(address_sanitizer)
+#  define WZ_POOL_USE_HEAP
+# endif
+#endif
+
+/// Size of the header before each object, which holds the generation counter. Keeps objects as aligned as malloc does.
+static const size_t poolHeaderSize = 16;
+/// Slabs are about this big, unless the objects are large.
+static const size_t poolSlabSize = 65536;
+
+static WzPool *firstPool = NULL;  // Not a class member, so it is NULL before any pool is constructed, whatever order the pools are constructed in.
+
+/// The header of a block. While the block is free, the next free block is stored where the object would be.
+struct WzPool::Block
+{
+	uint32_t generation;
+};
+
+static inline uint32_t *blockGeneration(void const *ptr)
+{
+	return (uint32_t *)((char *)ptr - poolHeaderSize);
+}
+
+static inline void *blockObject(void *block)
+{
+	return (char *)block + poolHeaderSize;
+}
+
+WzPool::WzPool(const char *name_, size_t objectSize_)
+	: name(name_)
+	, objectSize(objectSize_)
+	, blockSize(poolHeaderSize + (std::max(objectSize_, sizeof(Block *)) + poolHeaderSize - 1) / poolHeaderSize * poolHeaderSize)
+	, blocksPerSlab(std::max<size_t>(poolSlabSize / blockSize, 16))
+	, freeBlocks(NULL)
+	, numUsed(0)
+	, maxUsed(0)
+	, numAllocs(0)
+	, nextPool(firstPool)
+{
+	firstPool = this;
+}
+
+WzPool::~WzPool()
+{
+	for (WzPool **pool = &firstPool; *pool != NULL; pool = &(*pool)->nextPool)
+	{
+		if (*pool == this)
+		{
+			*pool = nextPool;
+			break;
+		}
+	}
+	if (numUsed != 0)
+	{
+		return;  // Some objects were never freed, and might still be used while exiting, so leave them be.
+	}
+	for (unsigned i = 0; i < slabs.size(); ++i)
+	{
+		::free(slabs[i]);
+	}
+}
+
+void *WzPool::alloc(size_t size)
+{
+	if (size != objectSize)
+	{
+		return ::operator new(size);
+	}
+
+#ifdef WZ_POOL_USE_HEAP
+	Block *heapBlock = (Block *)malloc(poolHeaderSize + objectSize);
+	if (heapBlock == NULL)
+	{
+		throw std::bad_alloc();
+	}
+	heapBlock->generation = 0;
+	++numUsed;
+	maxUsed = std::max(maxUsed, numUsed);
+	++numAllocs;
+	return blockObject(heapBlock);
+#endif
+
+	if (freeBlocks == NULL)
+	{
+		char *slab = (char *)malloc(blockSize * blocksPerSlab);
+		if (slab == NULL)
+		{
+			debug(LOG_FATAL, "Out of memory for %s pool", name);
+			throw std::bad_alloc();
+		}
+		slabs.push_back(slab);
+		// Link the blocks in reverse, so that the first block is allocated first.
+		for (size_t i = blocksPerSlab; i-- > 0;)
+		{
+			Block *block = (Block *)(slab + i * blockSize);
+			block->generation = 0;
+			*(Block **)blockObject(block) = freeBlocks;
+			freeBlocks = block;
+		}
+	}
+
+	Block *block = freeBlocks;
+	freeBlocks = *(Block **)blockObject(block);
+	++numUsed;
+	maxUsed = std::max(maxUsed, numUsed);
+	++numAllocs;
+	return blockObject(block);
+}
+
+void WzPool::free(void *ptr, size_t size)
+{
+	if (ptr == NULL)
+	{
+		return;
+	}
+	if (size != objectSize)
+	{
+		::operator delete(ptr);
+		return;
+	}
+
+#ifdef WZ_POOL_USE_HEAP
+	::free(blockGeneration(ptr));
+	--numUsed;
+	return;
+#endif
+
+	++*blockGeneration(ptr);
+	*(Block **)ptr = freeBlocks;
+	freeBlocks = (Block *)blockGeneration(ptr);
+	--numUsed;
+}
+
+uint32_t WzPool::generation(void const *ptr)
+{
+	return *blockGeneration(ptr);
+}
+
+void WzPool::logStats()
+{
+	for (WzPool *pool = firstPool; pool != NULL; pool = pool->nextPool)
+	{
+		debug(LOG_MEMORY, "%s pool: %u in use, at most %u, %llu allocated in total, %u slabs of %u bytes", pool->name, (unsigned)pool->numUsed, (unsigned)pool->maxUsed,
+		      (unsigned long long)pool->numAllocs, (unsigned)pool->slabs.size(), (unsigned)(pool->blockSize * pool->blocksPerSlab));
+	}
+}
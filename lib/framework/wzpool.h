@@ -0,0 +1,75 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2016  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Pools of fixed size memory blocks, for objects which are created and destroyed often, such as game objects.
+ *
+ *  The blocks are cut from large slabs, which are not moved or freed while the pool is in use, so objects of the
+ *  same type are kept close together in memory instead of being spread around the heap. Freed blocks are reused,
+ *  most recently freed first. A pool must only be used from one thread at a time.
+ *
+ *  When built with AddressSanitizer, each block is allocated on the heap and freed straight away instead, so that uses
+ *  of freed objects are still reported.
+ */
+
+#ifndef _wzpool_h
+#define _wzpool_h
+
+#include "wzglobal.h"
+#include "types.h"
+
+#include <vector>
+
+class WzPool
+{
+public:
+	/// The name must be a string literal, and is used by logStats.
+	WzPool(const char *name, size_t objectSize);
+	~WzPool();
+
+	/// Returns a block for an object of the given size. Objects of another size than the one the pool was made for, such as subclasses, are allocated on the heap instead.
+	void *alloc(size_t objectSize);
+	/// Frees a block returned by alloc(objectSize).
+	void free(void *ptr, size_t objectSize);
+
+	/// Number of times the block of an object allocated from a pool was freed. Can be stored along with a pointer to the object, to find out later whether the object is gone, even if another object was since allocated at the same address.
+	/// Must only be called for objects of the size the pool was made for, since objects of other sizes are on the heap with no generation counter before them.
+	static uint32_t generation(void const *ptr);
+
+	/// Logs the number of objects, the most objects at once, and the memory used, of each pool, with LOG_MEMORY.
+	static void logStats();
+
+	WzPool(const WzPool &) = delete;
+	WzPool &operator =(const WzPool &) = delete;
+
+private:
+	struct Block;
+
+	const char *name;
+	size_t objectSize;
+	size_t blockSize;              ///< objectSize, plus the generation counter, rounded up for alignment.
+	size_t blocksPerSlab;
+	std::vector<char *> slabs;
+	Block *freeBlocks;             ///< Linked list of unused blocks.
+	size_t numUsed;
+	size_t maxUsed;
+	uint64_t numAllocs;
+	WzPool *nextPool;              ///< Linked list of all pools, for logStats.
+};
+
+#endif // _wzpool_h
@@ -0,0 +1,205 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2016  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Scoped timers for finding out where the time of a game tick goes.
+ */
+
+#include "frame.h"
+#include "wzapp.h"
+#include "wzprofile.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QThread>
+#include <physfs.h>
+#include <map>
+#include <string>
+
+bool wzProfileEnabled = false;
+
+/// Upper limits of the histogram buckets, in microseconds. The last bucket has no upper limit.
+static const int64_t bucketLimits[] = {100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000};
+#define PROFILE_BUCKETS (ARRAY_SIZE(bucketLimits) + 1)
+
+struct PROFILE_BIN
+{
+	PROFILE_BIN() : calls(0), time(0), worst(0) { memset(buckets, 0, sizeof(buckets)); }
+
+	uint64_t calls;
+	int64_t time;                        ///< Total time, in nanoseconds.
+	int64_t worst;                       ///< Longest time, in nanoseconds.
+	uint64_t buckets[PROFILE_BUCKETS];
+};
+
+static QElapsedTimer profileTimer;
+static wz::mutex profileMutex;                        ///< Protects everything below, since scopes are also timed in other threads.
+static std::map<std::string, PROFILE_BIN> profileBins;
+static QHash<Qt::HANDLE, int> profileThreads;         ///< Small thread numbers, for the trace.
+static PHYSFS_file *traceFile = NULL;
+static std::string traceBuffer;                      ///< Trace data not yet written to traceFile.
+static const size_t traceBufferSize = 65536;
+
+static void traceFlush()
+{
+	if (traceFile != NULL && !traceBuffer.empty())
+	{
+		if (PHYSFS_write(traceFile, traceBuffer.data(), traceBuffer.size(), 1) != 1)
+		{
+			debug(LOG_ERROR, "Could not write profiling trace: %s", PHYSFS_getLastError());
+			PHYSFS_close(traceFile);
+			traceFile = NULL;
+		}
+	}
+	traceBuffer.clear();
+}
+
+/// Must hold profileMutex.
+static int profileThread()
+{
+	Qt::HANDLE handle = QThread::currentThreadId();
+	QHash<Qt::HANDLE, int>::const_iterator i = profileThreads.constFind(handle);
+	if (i != profileThreads.constEnd())
+	{
+		return i.value();
+	}
+	int tid = profileThreads.size() + 1;
+	profileThreads.insert(handle, tid);
+	return tid;
+}
+
+bool wzProfileStart(const char *traceFilename)
+{
+	ASSERT_OR_RETURN(false, !wzProfileEnabled, "Already profiling");
+
+	traceFile = PHYSFS_openWrite(traceFilename);
+	if (traceFile == NULL)
+	{
+		debug(LOG_ERROR, "Could not create profiling trace %s: %s", traceFilename, PHYSFS_getLastError());
+		return false;
+	}
+	traceBuffer = "{\"traceEvents\":[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"warzone2100\"}}";
+	profileTimer.start();
+	wzProfileEnabled = true;
+	wzProfileThreadName("main");
+	debug(LOG_INFO, "Writing profiling trace to %s", traceFilename);
+	return true;
+}
+
+void wzProfileShutdown()
+{
+	if (!wzProfileEnabled)
+	{
+		return;
+	}
+	wzProfileEnabled = false;
+
+	profileMutex.lock();
+	traceBuffer += "\n]}\n";
+	traceFlush();
+	if (traceFile != NULL)
+	{
+		PHYSFS_close(traceFile);
+		traceFile = NULL;
+	}
+
+	std::string header = "    calls | avg (usec) | worst (usec) |";
+	for (unsigned i = 0; i < PROFILE_BUCKETS; ++i)
+	{
+		char limit[32];
+		ssprintf(limit, " %s%lldus", i < ARRAY_SIZE(bucketLimits) ? "<" : ">=", (long long)bucketLimits[std::min<unsigned>(i, ARRAY_SIZE(bucketLimits) - 1)]);
+		header += limit;
+	}
+	debug(LOG_INFO, "=== PROFILING DATA ===");
+	debug(LOG_INFO, "%s | scope", header.c_str());
+	for (std::map<std::string, PROFILE_BIN>::const_iterator i = profileBins.begin(); i != profileBins.end(); ++i)
+	{
+		const PROFILE_BIN &bin = i->second;
+		std::string buckets;
+		for (unsigned b = 0; b < PROFILE_BUCKETS; ++b)
+		{
+			char count[32];
+			ssprintf(count, " %llu", (unsigned long long)bin.buckets[b]);
+			buckets += count;
+		}
+		debug(LOG_INFO, "%9llu | %10lld | %12lld |%s | %s", (unsigned long long)bin.calls, (long long)(bin.time / bin.calls / 1000), (long long)(bin.worst / 1000), buckets.c_str(), i->first.c_str());
+	}
+	profileBins.clear();
+	profileThreads.clear();
+	profileMutex.unlock();
+}
+
+void wzProfileThreadName(const char *name)
+{
+	if (!wzProfileEnabled)
+	{
+		return;
+	}
+
+	char event[256];
+	profileMutex.lock();
+	ssprintf(event, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", profileThread(), name);
+	traceBuffer += event;
+	profileMutex.unlock();
+}
+
+int64_t wzProfileTime()
+{
+	return profileTimer.nsecsElapsed();
+}
+
+void wzProfileRecord(const char *name, int arg, int64_t begin, int64_t end)
+{
+	int64_t duration = end - begin;
+	int64_t durationUs = duration / 1000;
+	unsigned bucket = 0;
+	while (bucket < ARRAY_SIZE(bucketLimits) && durationUs >= bucketLimits[bucket])
+	{
+		++bucket;
+	}
+
+	char event[256];
+	profileMutex.lock();
+	if (!wzProfileEnabled)
+	{
+		profileMutex.unlock();
+		return;  // Stopped while the scope was running.
+	}
+
+	PROFILE_BIN &bin = profileBins[name];
+	++bin.calls;
+	bin.time += duration;
+	bin.worst = std::max(bin.worst, duration);
+	++bin.buckets[bucket];
+
+	int tid = profileThread();
+	if (arg != -1)
+	{
+		ssprintf(event, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"arg\":%d}}", name, tid, begin / 1000., duration / 1000., arg);
+	}
+	else
+	{
+		ssprintf(event, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", name, tid, begin / 1000., duration / 1000.);
+	}
+	traceBuffer += event;
+	if (traceBuffer.size() >= traceBufferSize)
+	{
+		traceFlush();
+	}
+	profileMutex.unlock();
+}
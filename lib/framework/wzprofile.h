@@ -0,0 +1,66 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2016  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Scoped timers for finding out where the time of a game tick goes.
+ *
+ *  When enabled, every WzProfileScope is written to a trace file in the Chrome trace event format, which can be
+ *  opened in chrome://tracing or Perfetto, and a histogram of the time taken by each scope is logged on shutdown.
+ *  When disabled, a WzProfileScope costs a single check of a global flag.
+ */
+
+#ifndef _wzprofile_h
+#define _wzprofile_h
+
+#include "wzglobal.h"
+#include "types.h"
+
+/// Enables profiling, writing the trace to the given file in the write directory.
+bool wzProfileStart(const char *traceFilename);
+/// Logs the histogram summary, and finishes writing the trace. Does nothing if profiling was not started.
+void wzProfileShutdown();
+/// Names the calling thread in the trace.
+void wzProfileThreadName(const char *name);
+
+void wzProfileRecord(const char *name, int arg, int64_t begin, int64_t end);  ///< Used by WzProfileScope.
+int64_t wzProfileTime();                                                       ///< Used by WzProfileScope. In nanoseconds.
+extern bool wzProfileEnabled;                                                  ///< Used by WzProfileScope.
+
+/// Times its own lifetime. The name must be a string literal, and is used to group the timings in the summary. The arg, if not -1, is usually a player number, and is shown in the trace.
+class WzProfileScope
+{
+public:
+	explicit WzProfileScope(const char *name_, int arg_ = -1) : name(wzProfileEnabled ? name_ : NULL), arg(arg_), begin(name != NULL ? wzProfileTime() : 0) {}
+	~WzProfileScope()
+	{
+		if (name != NULL)
+		{
+			wzProfileRecord(name, arg, begin, wzProfileTime());
+		}
+	}
+
+	WzProfileScope(const WzProfileScope &) = delete;
+	WzProfileScope &operator =(const WzProfileScope &) = delete;
+
+private:
+	const char *name;
+	int arg;
+	int64_t begin;
+};
+
+#endif // _wzprofile_h
@@ -42,6 +42,9 @@ float graphicsTimeFraction = 0.0, realTimeFraction = 0.0;
 /** The current clock modifier. Set to speed up the game. */
 static Rational modifier;
 
+/** If set, ignore the real time and tick the game as fast as possible. */
+static bool unlimitedSpeed = false;
+
 /// The real time, the last time graphicsTime updated.
 static uint32_t prevRealTime;
 
@@ -170,6 +173,10 @@ void gameTimeUpdate(bool mayUpdate)
 
 	// Calculate the new game time
 	int newDeltaGraphicsTime = quantiseFraction(modifier.n, modifier.d, currTime, prevRealTime);
+	if (unlimitedSpeed)
+	{
+		newDeltaGraphicsTime = gameTime + 1 - graphicsTime;  // Always just past gameTime, so we tick whenever allowed to.
+	}
 	ASSERT(newDeltaGraphicsTime >= 0, "Something very wrong.");
 
 	uint32_t newGraphicsTime = graphicsTime + newDeltaGraphicsTime;
@@ -206,6 +213,14 @@ void gameTimeUpdate(bool mayUpdate)
 	// Adjust deltas.
 	if (newGraphicsTime > gameTime)
 	{
+		if (unlimitedSpeed)
+		{
+			// Ticking every time, so the graphics time would never get its turn. Catch up to the previous game time instead.
+			deltaGraphicsTime = gameTime - graphicsTime;
+			graphicsTime      = gameTime;
+			prevRealTime      = currTime;
+		}
+
 		// Update the game time.
 		deltaGameTime = GAME_TICKS_PER_UPDATE;
 		gameTime += deltaGameTime;
@@ -275,6 +290,11 @@ Rational gameTimeGetMod()
 	return modifier;
 }
 
+void gameTimeSetUnlimited(bool unlimited)
+{
+	unlimitedSpeed = unlimited;
+}
+
 bool gameTimeIsStopped(void)
 {
 	return stopCount != 0;
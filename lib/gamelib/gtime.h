@@ -99,6 +99,9 @@ void gameTimeSetMod(Rational mod);
 /** Get the current time modifier. */
 Rational gameTimeGetMod();
 
+/** Let gameTime tick as soon as all players allow it, regardless of how much real time has passed. Used when running without display. */
+void gameTimeSetUnlimited(bool unlimited);
+
 /**
  * Returns the game time, modulo the time period, scaled to 0..requiredRange.
  * For instance getModularScaledGameTime(4096,256) will return a number that cycles through the values
@@ -35,6 +35,7 @@
 #include "lib/framework/physfs_ext.h"
 #include "lib/ivis_opengl/piematrix.h"
 #include "lib/ivis_opengl/piestate.h"
+#include "lib/ivis_opengl/piemode.h"
 
 #include "ivisdef.h" // for imd structures
 #include "imd.h" // for imd structures
@@ -101,7 +102,10 @@ static void iV_IMDRelease(iIMDShape *s)
 			free(s->shadowEdgeList);
 			s->shadowEdgeList = NULL;
 		}
-		glDeleteBuffers(VBO_COUNT, s->buffers);
+		if (!pie_Headless())
+		{
+			glDeleteBuffers(VBO_COUNT, s->buffers);
+		}
 		// shader deleted later, if any
 		d = s->next;
 		delete s;
@@ -793,6 +797,11 @@ static iIMDShape *_imd_load_level(const QString &filename, const char **ppFileDa
 	}
 
 	// FINALLY, massage the data into what can stream directly to OpenGL
+	if (pie_Headless())
+	{
+		*ppFileData = pFileData;
+		return s;
+	}
 	glGenBuffers(VBO_COUNT, s->buffers);
 	vertexCount = 0;
 	for (int k = 0; k < MAX(1, s->numFrames); k++)
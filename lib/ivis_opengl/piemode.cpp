@@ -47,10 +47,27 @@
 
 iSurface rendSurface;
 
+static bool headless = false;
+
+void pie_SetHeadless(bool value)
+{
+	headless = value;
+}
+
+bool pie_Headless(void)
+{
+	return headless;
+}
+
 bool pie_Initialise(void)
 {
-	pie_SetUp();
 	pie_TexInit();
+	if (headless)
+	{
+		debug(LOG_3D, "Running without a renderer");
+		return true;
+	}
+	pie_SetUp();
 
 	/* Find texture compression extension */
 	if (GLEW_ARB_texture_compression && wz_texture_compression != GL_RGBA)
@@ -91,6 +108,11 @@ void pie_ScreenFlip(int clearMode)
 {
 	GLbitfield clearFlags = 0;
 
+	if (headless)
+	{
+		return;
+	}
+
 	screenDoDumpToDiskIfRequired();
 	wzScreenFlip();
 	wzPerfFrame();
@@ -54,5 +54,8 @@ extern bool pie_Initialise(void);
 extern void pie_ShutDown(void);
 extern void pie_ScreenFlip(int ClearMode);
 extern UDWORD	pie_GetResScalingFactor(void);
+/// Turns every OpenGL call made while loading and flipping into a no-op, for running the game simulation without a window.
+extern void pie_SetHeadless(bool headless);
+extern bool pie_Headless(void);
 
 #endif
@@ -27,6 +27,7 @@
 
 #include "lib/ivis_opengl/pieblitfunc.h"
 #include "lib/ivis_opengl/piestate.h"
+#include "lib/ivis_opengl/piemode.h"
 #include "lib/ivis_opengl/piedef.h"
 #include "lib/ivis_opengl/tex.h"
 #include "lib/ivis_opengl/piepalette.h"
@@ -222,6 +223,11 @@ SHADER_MODE pie_LoadShader(const char *programName, const char *vertexPath, cons
 	bool success = true; // Assume overall success
 	char *buffer[2];
 
+	if (pie_Headless())
+	{
+		return SHADER_NONE;
+	}
+
 	program.program = glCreateProgram();
 	glBindAttribLocation(program.program, 0, "vertex");
 	glBindAttribLocation(program.program, 1, "vertexTexCoord");
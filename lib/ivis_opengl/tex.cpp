@@ -24,6 +24,7 @@
 
 #include "lib/ivis_opengl/ivisdef.h"
 #include "lib/ivis_opengl/piestate.h"
+#include "lib/ivis_opengl/piemode.h"
 #include "lib/ivis_opengl/tex.h"
 #include "lib/ivis_opengl/piepalette.h"
 #include "lib/ivis_opengl/png_util.h"
@@ -57,7 +58,11 @@ int pie_NumberOfPages()
 int pie_ReserveTexture(const char *name)
 {
 	iTexPage tex;
-	glGenTextures(1, &tex.id);
+	tex.id = 0;
+	if (!pie_Headless())
+	{
+		glGenTextures(1, &tex.id);
+	}
 	sstrcpy(tex.name, name);
 	_TEX_PAGE.append(tex);
 	return _TEX_PAGE.size() - 1;
@@ -71,7 +76,11 @@ int pie_AddTexPage(iV_Image *s, const char *filename, bool gameTexture, int page
 	{
 		iTexPage tex;
 		page = _TEX_PAGE.size();
-		glGenTextures(1, &tex.id);
+		tex.id = 0;
+		if (!pie_Headless())
+		{
+			glGenTextures(1, &tex.id);
+		}
 		sstrcpy(tex.name, filename);
 		_TEX_PAGE.append(tex);
 	}
@@ -82,6 +91,14 @@ int pie_AddTexPage(iV_Image *s, const char *filename, bool gameTexture, int page
 	}
 	debug(LOG_TEXTURE, "%s page=%d", filename, page);
 
+	if (pie_Headless())
+	{
+		// Nothing to upload to, but keep the page so that the models referring to it stay valid.
+		free(s->bmp);
+		s->bmp = NULL;
+		return page;
+	}
+
 	pie_SetTexturePage(page);
 	if (GLEW_VERSION_4_3 || GLEW_KHR_debug)
 	{
@@ -229,7 +246,7 @@ void pie_TexShutDown(void)
 	// TODO, lazy deletions for faster loading of next level
 	debug(LOG_TEXTURE, "Cleaning out %u textures", _TEX_PAGE.size());
 	int _TEX_INDEX = _TEX_PAGE.size() - 1;
-	while (_TEX_INDEX > 0)
+	while (_TEX_INDEX > 0 && !pie_Headless())
 	{
 		glDeleteTextures(1, &_TEX_PAGE[_TEX_INDEX--].id);
 	}
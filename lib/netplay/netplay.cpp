@@ -43,6 +43,7 @@
 
 #include "netplay.h"
 #include "netlog.h"
+#include "netreplay.h"
 #include "netsocket.h"
 
 #include <miniupnpc/miniwget.h>
@@ -1896,12 +1897,16 @@ bool NETrecvGame(NETQUEUE *queue, uint8_t *type)
 		*queue = NETgameQueue(current);
 		while (!checkPlayerGameTime(current))  // Check for any messages that are scheduled to be read now.
 		{
+			while (!NETisMessageReady(*queue) && NETreplayLoadNetMessage())
+			{}  // When playing back a replay, the recorded messages are read in the order they are needed.
+
 			if (!NETisMessageReady(*queue))
 			{
 				return false;  // Still waiting for messages from this player, and all players should process messages in the same order. Will have to freeze the game while waiting.
 			}
 
 			*type = NETgetMessage(*queue)->type;
+			NETreplaySaveNetMessage(NETgetMessage(*queue), current);
 
 			if (*type == GAME_GAME_TIME)
 			{
@@ -0,0 +1,279 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2016  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/**
+ * @file netreplay.cpp
+ *
+ * Recording and playback of the game queue messages of a game.
+ *
+ * File layout, all integers big endian:
+ *	char[8]   "WZreplay"
+ *	uint32_t  version
+ *	uint32_t  length of the game settings
+ *	char[]    game settings, as given to NETreplaySaveStart
+ * followed by one record per message:
+ *	varint    gameTime since the previous record
+ *	uint8_t   player, the game queue the message was read from
+ *	uint8_t   message type
+ *	varint    message length
+ *	uint8_t[] message data
+ * where varint is the encoding used by NetMessage::rawDataDup.
+ */
+
+#include "lib/framework/frame.h"
+#include "lib/framework/file.h"
+#include "lib/framework/physfs_ext.h"
+#include "lib/gamelib/gtime.h"
+
+#include <physfs.h>
+
+#include "netreplay.h"
+#include "nettypes.h"
+
+static const char replayMagic[8] = {'W', 'Z', 'r', 'e', 'p', 'l', 'a', 'y'};
+static const uint32_t replayVersion = 1;
+static const size_t replayBufferSize = 65536;  ///< Write to the file in chunks of about this size.
+
+static PHYSFS_file          *replaySaveHandle = NULL;
+static std::vector<uint8_t>  replaySaveBuffer;        ///< Messages not yet written to replaySaveHandle.
+static uint32_t              replaySaveTime = 0;      ///< gameTime of the last recorded message.
+
+static char                 *replayLoadData = NULL;   ///< Whole replay file, while playing back.
+static UDWORD                replayLoadSize = 0;
+static UDWORD                replayLoadPos = 0;       ///< Next record in replayLoadData.
+static uint32_t              replayLoadTime = 0;      ///< gameTime of the last loaded message.
+static bool                  replayLoading = false;
+static bool                  replayFinished = false;
+
+static bool replayFlushBuffer()
+{
+	if (replaySaveBuffer.empty())
+	{
+		return true;
+	}
+	bool ok = PHYSFS_write(replaySaveHandle, &replaySaveBuffer[0], replaySaveBuffer.size(), 1) == 1;
+	replaySaveBuffer.clear();
+	return ok;
+}
+
+static void replayAppendVarint(uint32_t v)
+{
+	unsigned len = encodedlength_uint32_t(v);
+	for (unsigned n = 0; n < len; ++n)
+	{
+		uint8_t b;
+		encode_uint32_t(b, v, n);
+		replaySaveBuffer.push_back(b);
+	}
+}
+
+static bool replayReadVarint(uint32_t &v)
+{
+	v = 0;
+	bool moreBytes = true;
+	for (unsigned n = 0; moreBytes; ++n)
+	{
+		if (replayLoadPos >= replayLoadSize || n >= 5)
+		{
+			return false;
+		}
+		moreBytes = decode_uint32_t(replayLoadData[replayLoadPos++], v, n);
+	}
+	return true;
+}
+
+static uint32_t replayReadUBE32(UDWORD pos)
+{
+	const uint8_t *p = reinterpret_cast<const uint8_t *>(replayLoadData + pos);
+	return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+bool NETreplaySaveStart(const char *filename, std::string const &settings)
+{
+	ASSERT_OR_RETURN(false, replaySaveHandle == NULL, "Already recording a replay");
+
+	replaySaveHandle = PHYSFS_openWrite(filename);
+	if (replaySaveHandle == NULL)
+	{
+		debug(LOG_ERROR, "Could not create replay %s: %s", filename, PHYSFS_getLastError());
+		return false;
+	}
+
+	if (PHYSFS_write(replaySaveHandle, replayMagic, sizeof(replayMagic), 1) != 1
+	    || !PHYSFS_writeUBE32(replaySaveHandle, replayVersion)
+	    || !PHYSFS_writeUBE32(replaySaveHandle, settings.size())
+	    || (!settings.empty() && PHYSFS_write(replaySaveHandle, settings.data(), settings.size(), 1) != 1))
+	{
+		debug(LOG_ERROR, "Could not write replay header to %s: %s", filename, PHYSFS_getLastError());
+		PHYSFS_close(replaySaveHandle);
+		replaySaveHandle = NULL;
+		return false;
+	}
+
+	replaySaveBuffer.clear();
+	replaySaveBuffer.reserve(replayBufferSize + 1024);
+	replaySaveTime = 0;
+	debug(LOG_NET, "Recording replay to %s", filename);
+	return true;
+}
+
+bool NETreplaySaveStop()
+{
+	if (replaySaveHandle == NULL)
+	{
+		return false;
+	}
+
+	bool ok = replayFlushBuffer();
+	ok = PHYSFS_close(replaySaveHandle) != 0 && ok;
+	replaySaveHandle = NULL;
+	if (!ok)
+	{
+		debug(LOG_ERROR, "Could not write replay: %s", PHYSFS_getLastError());
+	}
+	return ok;
+}
+
+void NETreplaySaveNetMessage(NetMessage const *message, uint8_t player)
+{
+	if (replaySaveHandle == NULL)
+	{
+		return;
+	}
+
+	ASSERT(gameTime >= replaySaveTime, "Time went backwards, from %u to %u", replaySaveTime, gameTime);
+	replayAppendVarint(gameTime - replaySaveTime);
+	replaySaveTime = gameTime;
+	replaySaveBuffer.push_back(player);
+
+	uint8_t *raw = message->rawDataDup();
+	replaySaveBuffer.insert(replaySaveBuffer.end(), raw, raw + message->rawLen());
+	delete[] raw;
+
+	if (replaySaveBuffer.size() >= replayBufferSize && !replayFlushBuffer())
+	{
+		debug(LOG_ERROR, "Could not write replay, stopping recording: %s", PHYSFS_getLastError());
+		PHYSFS_close(replaySaveHandle);
+		replaySaveHandle = NULL;
+	}
+}
+
+bool NETreplayLoadStart(const char *filename, std::string &settings)
+{
+	NETreplayLoadStop();
+
+	if (!PHYSFS_exists(filename) || !loadFile(filename, &replayLoadData, &replayLoadSize))
+	{
+		debug(LOG_ERROR, "Could not open replay %s", filename);
+		return false;
+	}
+
+	const UDWORD headerSize = sizeof(replayMagic) + 4 + 4;
+	if (replayLoadSize < headerSize || memcmp(replayLoadData, replayMagic, sizeof(replayMagic)) != 0)
+	{
+		debug(LOG_ERROR, "%s is not a replay", filename);
+		NETreplayLoadStop();
+		return false;
+	}
+	uint32_t version = replayReadUBE32(sizeof(replayMagic));
+	if (version != replayVersion)
+	{
+		debug(LOG_ERROR, "Replay %s has version %u, expected version %u", filename, version, replayVersion);
+		NETreplayLoadStop();
+		return false;
+	}
+	uint32_t settingsSize = replayReadUBE32(sizeof(replayMagic) + 4);
+	if (settingsSize > replayLoadSize - headerSize)
+	{
+		debug(LOG_ERROR, "Replay %s is truncated", filename);
+		NETreplayLoadStop();
+		return false;
+	}
+
+	settings.assign(replayLoadData + headerSize, settingsSize);
+	replayLoadPos = headerSize + settingsSize;
+	replayLoadTime = 0;
+	replayLoading = true;
+	replayFinished = false;
+	debug(LOG_NET, "Playing back replay %s", filename);
+	return true;
+}
+
+bool NETreplayLoadStop()
+{
+	bool wasLoading = replayLoading;
+
+	free(replayLoadData);
+	replayLoadData = NULL;
+	replayLoadSize = 0;
+	replayLoadPos = 0;
+	replayLoading = false;
+	replayFinished = false;
+	return wasLoading;
+}
+
+bool NETreplayLoadNetMessage()
+{
+	if (!replayLoading || replayFinished)
+	{
+		return false;
+	}
+
+	uint32_t deltaTime, len;
+	NetMessage message;
+	uint8_t player = 0;
+	bool ok = replayReadVarint(deltaTime) && replayLoadPos + 2 <= replayLoadSize;
+	if (ok)
+	{
+		player = replayLoadData[replayLoadPos++];
+		message.type = replayLoadData[replayLoadPos++];
+		ok = player < MAX_PLAYERS && replayReadVarint(len) && len <= replayLoadSize - replayLoadPos;
+	}
+	if (!ok)
+	{
+		if (replayLoadPos < replayLoadSize)
+		{
+			debug(LOG_ERROR, "Replay is corrupt at byte %u of %u", replayLoadPos, replayLoadSize);
+		}
+		debug(LOG_INFO, "Replay finished at gameTime %u", gameTime);
+		replayFinished = true;
+		return false;
+	}
+	message.data.assign(replayLoadData + replayLoadPos, replayLoadData + replayLoadPos + len);
+	replayLoadPos += len;
+
+	replayLoadTime += deltaTime;
+	if (replayLoadTime < gameTime)
+	{
+		// Messages are loaded as soon as they are needed, so should never be loaded late, unless the game went a different way than when it was recorded.
+		debug(LOG_WARNING, "Replay out of synch, gameTime is %u, but message was recorded at gameTime %u", gameTime, replayLoadTime);
+	}
+
+	NETinsertMessageFromNet(NETgameQueue(player), &message);
+	return true;
+}
+
+bool NETisReplay()
+{
+	return replayLoading;
+}
+
+bool NETisReplayFinished()
+{
+	return replayLoading && replayFinished;
+}
@@ -0,0 +1,49 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2016  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/**
+ * @file netreplay.h
+ *
+ * Recording and playback of the game queue messages of a game.
+ */
+#ifndef _net_replay_h
+#define _net_replay_h
+
+#include "lib/framework/frame.h"
+
+#include "netqueue.h"
+
+#include <string>
+
+// A replay file consists of a header, containing the game settings given by the caller, followed by every message that
+// NETrecvGame delivered to the game, in the order they were delivered, each tagged with the player queue it was read
+// from and the gameTime at which it was read. Feeding those messages back into the game queues, in the same order,
+// makes the game simulation repeat itself exactly, without any other players or sockets.
+
+bool NETreplaySaveStart(const char *filename, std::string const &settings);  ///< Starts recording to the given file in the write directory.
+bool NETreplaySaveStop();                                                   ///< Stops recording, and writes any buffered messages to the file.
+void NETreplaySaveNetMessage(NetMessage const *message, uint8_t player);    ///< Records a game message, which is about to be delivered to the game.
+
+bool NETreplayLoadStart(const char *filename, std::string &settings);       ///< Opens a replay for playback, and returns the game settings which were recorded with it.
+bool NETreplayLoadStop();                                                   ///< Stops playback.
+bool NETreplayLoadNetMessage();                                             ///< Inserts the next recorded message into its game queue. Returns false if not playing back, or if there are no more messages.
+
+bool NETisReplay();                                                         ///< True while playing back a replay. Game messages sent locally are then discarded.
+bool NETisReplayFinished();                                                 ///< True when playing back a replay, and all recorded messages have been used up.
+
+#endif // _net_replay_h
@@ -1062,6 +1062,11 @@ void wzYieldCurrentThread()
 #endif
 }
 
+int wzGetCPUCount()
+{
+	return QThread::idealThreadCount();
+}
+
 WZ_MUTEX *wzMutexCreate()
 {
 	return new WZ_MUTEX;
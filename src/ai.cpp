@@ -35,6 +35,8 @@
 #include "objmem.h"
 #include "order.h"
 
+#include <unordered_map>
+
 /* Weights used for target selection code,
  * target distance is used as 'common currency'
  */
@@ -63,6 +65,11 @@
 
 #define TOO_CLOSE_PENALTY_F             20
 
+#define TARGET_SEARCH_BUDGET		64	// Target searches per tick, not counting urgent ones, shared evenly between the players
+#define TARGET_SEARCH_URGENT_BUDGET	256	// Target searches per tick, counting urgent ones, shared evenly between the players
+
+#define TARGET_CACHE_SHIFT		9	// Target candidates are cached for cells of 4x4 tiles, and for ranges rounded up to a multiple of 4 tiles
+
 #define TARGET_DOOMED_PENALTY_F		10	// Targets that have a lot of damage incoming are less attractive
 #define TARGET_DOOMED_SLOW_RELOAD_T	21	// Weapon ROF threshold for above penalty. per minute.
 
@@ -161,6 +168,128 @@ bool aiShutdown(void)
 	return true;
 }
 
+static uint32_t targetSearchTime = 0;                ///< The game time targetSearchCount is for.
+static unsigned targetSearchCount[MAX_PLAYERS];      ///< Target searches done this tick, by each player.
+static unsigned targetSearchPlayers = 1;             ///< Players with any droids or structures this tick.
+
+/** Whether psObj should search for a target this tick. Objects search once every interval, in a tick picked by their
+ *  id so that objects created together don't all search in the same tick, or as soon as possible if urgent. Objects
+ *  which were hit since their last search, or are overdue, get to search before the others, and hit objects search at
+ *  least every TARGET_SEARCH_INTERVAL. To avoid slow ticks, each player gets an even share of TARGET_SEARCH_BUDGET
+ *  searches that aren't urgent per tick, and of TARGET_SEARCH_URGENT_BUDGET searches in all, so the players updated
+ *  first can't use up the budget of the others. Objects which miss their turn wait for a later tick. This only depends
+ *  on the game state and the order the objects are updated in, so all players agree on it. */
+bool aiTargetSearchDue(BASE_OBJECT *psObj, unsigned interval, bool urgent)
+{
+	if (targetSearchTime != gameTime)
+	{
+		targetSearchTime = gameTime;
+		memset(targetSearchCount, 0, sizeof(targetSearchCount));
+		targetSearchPlayers = 0;
+		for (unsigned player = 0; player < MAX_PLAYERS; ++player)
+		{
+			targetSearchPlayers += apsDroidLists[player] != NULL || apsStructLists[player] != NULL;
+		}
+		targetSearchPlayers = std::max(targetSearchPlayers, 1u);
+	}
+
+	if (psObj->timeTargetSearch == 0)
+	{
+		psObj->timeTargetSearch = gameTime;  // Not searched yet, so only overdue after waiting from now on.
+	}
+	unsigned waited = gameTime - psObj->timeTargetSearch;
+	if (psObj->timeLastHit != UDWORD_MAX && psObj->timeLastHit >= psObj->timeTargetSearch)
+	{
+		// Hit since the last search, so look for whoever did it soon.
+		interval = std::min<unsigned>(interval, TARGET_SEARCH_INTERVAL);
+		urgent = urgent || waited >= interval;
+	}
+	unsigned turns = std::max<unsigned>(interval / GAME_TICKS_PER_UPDATE, 1);
+	bool ownTurn = (psObj->id + gameTime / GAME_TICKS_PER_UPDATE) % turns == 0;
+	bool missedTurn = (psObj->flags & BASEFLAG_TARGETSEARCH) != 0;
+	if (!urgent && !ownTurn && !missedTurn)
+	{
+		return false;
+	}
+	urgent = urgent || (missedTurn && waited >= interval * 2);  // Overdue, since the budget ran out on earlier ticks.
+	unsigned budget = urgent ? TARGET_SEARCH_URGENT_BUDGET : TARGET_SEARCH_BUDGET;
+	if (targetSearchCount[psObj->player] >= (budget + targetSearchPlayers - 1) / targetSearchPlayers)
+	{
+		psObj->flags |= BASEFLAG_TARGETSEARCH;
+		return false;  // Too many searches by this player this tick already.
+	}
+
+	++targetSearchCount[psObj->player];
+	psObj->timeTargetSearch = gameTime;
+	psObj->flags &= ~BASEFLAG_TARGETSEARCH;
+	return true;
+}
+
+/// Possible targets for everything of one player in one cell, with about the same range.
+struct TargetCandidates
+{
+	PlayerMask alliances;  ///< The player's alliances when the candidates were found.
+	GridList   objects;    ///< In grid order.
+};
+
+static std::unordered_map<uint64_t, TargetCandidates> targetCache;
+static unsigned targetCacheGeneration = 0;  ///< The gridGeneration() of targetCache.
+
+/** Returns all enemies of player which could be within range of (x, y), in grid order. They are shared by every droid
+ *  and structure of the same player close to (x, y), with a similar range, until the grid changes. Only features, allies, and objects
+ *  which were already dead are left out, since what each player can see changes as things are updated. */
+static GridList const &aiTargetCandidates(int player, int32_t x, int32_t y, int32_t range)
+{
+	if (targetCacheGeneration != gridGeneration())
+	{
+		targetCache.clear();
+		targetCacheGeneration = gridGeneration();
+	}
+
+	int32_t cellX = x >> TARGET_CACHE_SHIFT;
+	int32_t cellY = y >> TARGET_CACHE_SHIFT;
+	int32_t rangeClass = (range + (1 << TARGET_CACHE_SHIFT) - 1) >> TARGET_CACHE_SHIFT;
+	uint64_t key = (uint64_t)(uint16_t)cellX | (uint64_t)(uint16_t)cellY << 16 | (uint64_t)player << 32 | (uint64_t)rangeClass << 40;
+	std::unordered_map<uint64_t, TargetCandidates>::iterator i = targetCache.find(key);
+	if (i != targetCache.end() && i->second.alliances == alliancebits[player])
+	{
+		return i->second.objects;
+	}
+
+	TargetCandidates &candidates = targetCache[key];
+	candidates.alliances = alliancebits[player];
+	candidates.objects.clear();
+	int32_t margin = rangeClass << TARGET_CACHE_SHIFT;
+	GridList const &gridList = gridStartIterateArea((cellX << TARGET_CACHE_SHIFT) - margin, (cellY << TARGET_CACHE_SHIFT) - margin,
+	                                                ((cellX + 1) << TARGET_CACHE_SHIFT) + margin, ((cellY + 1) << TARGET_CACHE_SHIFT) + margin);
+	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
+	{
+		BASE_OBJECT *psObj = *gi;
+		if (psObj->type != OBJ_FEATURE && !psObj->died && !aiCheckAlliances(psObj->player, player))
+		{
+			candidates.objects.push_back(psObj);
+		}
+	}
+	return candidates.objects;
+}
+
+/** Whether the structure can keep shooting at its current target, without searching for a better one. */
+bool aiStructCanKeepTarget(STRUCTURE *psStruct, int weapon_slot)
+{
+	BASE_OBJECT *psTarget = psStruct->psTarget[weapon_slot];
+	if (psTarget == NULL || psTarget->died)
+	{
+		return false;
+	}
+	if (psStruct->asWeaps[weapon_slot].origin == ORIGIN_VISUAL && psTarget->visible[psStruct->player] != UBYTE_MAX)
+	{
+		return false;  // Can't see it any more.
+	}
+	WEAPON_STATS *psWStats = psStruct->asWeaps[weapon_slot].nStat + asWeaponStats;
+	return validTarget(psStruct, psTarget, weapon_slot) && aiStructHasRange(psStruct, psTarget, weapon_slot)
+	       && !aiObjectIsProbablyDoomed(psTarget, proj_Direct(psWStats));
+}
+
 /** Search the global list of sensors for a possible target for psObj. */
 static BASE_OBJECT *aiSearchSensorTargets(BASE_OBJECT *psObj, int weapon_slot, WEAPON_STATS *psWStats, TARGET_ORIGIN *targetOrigin)
 {
@@ -521,6 +650,108 @@ static SDWORD targetAttackWeight(BASE_OBJECT *psTarget, BASE_OBJECT *psAttacker,
 	return std::max<int>(1, attackWeight);
 }
 
+/// An upper limit of targetAttackWeight for the targets of a droid or structure, at least the weight of any target dist or further away.
+/// Lets the search for the best target stop before reaching the edge of the range. Must be kept in sync with targetAttackWeight.
+class TargetAttackWeightLimit
+{
+public:
+	TargetAttackWeightLimit(BASE_OBJECT *psAttacker, int weapon_slot)
+		: commandBonus(0)
+	{
+		WEAPON_STATS *attackerWeapon = asWeaponStats + psAttacker->asWeaps[weapon_slot].nStat;
+		WEAPON_EFFECT weaponEffect = attackerWeapon->weaponEffect;
+
+		int droidModifier = INT32_MIN;
+		for (int propulsion = 0; propulsion < PROPULSION_TYPE_NUM; ++propulsion)
+		{
+			for (int size = 0; size < SIZE_NUM; ++size)
+			{
+				droidModifier = std::max<int>(droidModifier, asWeaponModifier[weaponEffect][propulsion] + asWeaponModifierBody[weaponEffect][size]);
+			}
+		}
+		int structModifier = INT32_MIN;
+		for (int strength = 0; strength < NUM_STRUCT_STRENGTH; ++strength)
+		{
+			structModifier = std::max<int>(structModifier, asStructStrengthModifier[weaponEffect][strength]);
+		}
+
+		sensorRange = objSensorRange(psAttacker);
+		minRange = attackerWeapon->upgrade[psAttacker->player].minRange;
+		droidWeight = droidModifier + WEIGHT_DIST_TILE_DROID * sensorRange / TILE_UNITS + WEIGHT_HEALTH_DROID + std::max(std::max(WEIGHT_WEAPON_DROIDS, WEIGHT_COMMAND_DROIDS), WEIGHT_SERVICE_DROIDS);
+		structWeight = structModifier + WEIGHT_DIST_TILE_STRUCT * sensorRange / TILE_UNITS + WEIGHT_HEALTH_STRUCT + std::max(std::max(WEIGHT_WEAPON_STRUCT, WEIGHT_DERRICK_STRUCT), WEIGHT_MILITARY_STRUCT);
+
+		if (psAttacker->type == OBJ_DROID && hasCommander((DROID *)psAttacker))
+		{
+			// Droids attached to a commander also get the bonuses for defending it, and for helping the rest of the group.
+			DROID *psDroid = (DROID *)psAttacker;
+			commandBonus = WEIGHT_CMD_RANK * (1 + getDroidLevel(psDroid->psGroup->psCommander));
+			for (DROID *psGroupDroid = psDroid->psGroup->psList; psGroupDroid != NULL; psGroupDroid = psGroupDroid->psGrpNext)
+			{
+				commandBonus += WEIGHT_CMD_SAME_TARGET * psGroupDroid->numWeaps;
+			}
+		}
+	}
+
+	int operator ()(int32_t dist) const
+	{
+		if (dist <= minRange)
+		{
+			dist = std::min(dist, sensorRange);  // Targets too close to fire at are weighted as if at sensor range.
+		}
+		// Penalties only divide the weight, which is then at least 1.
+		return std::max(1, std::max(droidWeight - WEIGHT_DIST_TILE_DROID * dist / TILE_UNITS, structWeight - WEIGHT_DIST_TILE_STRUCT * dist / TILE_UNITS)) + commandBonus;
+	}
+
+private:
+	int sensorRange;
+	int minRange;
+	int droidWeight;   ///< Highest weight of a droid target at distance 0.
+	int structWeight;  ///< Highest weight of a structure target at distance 0.
+	int commandBonus;  ///< Highest weight added for being attached to a commander.
+};
+
+/// Whether the droid would attack targetInQuestion, if it is the best target within droidRange.
+static bool aiDroidConsidersTarget(DROID *psDroid, BASE_OBJECT *targetInQuestion, int weapon_slot, bool electronic, int droidRange)
+{
+	if (targetInQuestion == psDroid  // in case friendly unit had me as target
+	    || (targetInQuestion->type != OBJ_DROID && targetInQuestion->type != OBJ_STRUCTURE && targetInQuestion->type != OBJ_FEATURE)
+	    || targetInQuestion->visible[psDroid->player] != UBYTE_MAX
+	    || aiCheckAlliances(targetInQuestion->player, psDroid->player)
+	    || !validTarget(psDroid, targetInQuestion, weapon_slot)
+	    || objPosDiffSq(psDroid, targetInQuestion) >= droidRange * droidRange)
+	{
+		return false;
+	}
+
+	if (targetInQuestion->type == OBJ_DROID)
+	{
+		// in multiPlayer - don't attack Transporters with EW
+		return !bMultiPlayer || !electronic || !isTransporter((DROID *)targetInQuestion);
+	}
+	else if (targetInQuestion->type == OBJ_STRUCTURE)
+	{
+		STRUCTURE *psStruct = (STRUCTURE *)targetInQuestion;
+
+		if (electronic)
+		{
+			/* don't want to target structures with resistance of zero if using electronic warfare */
+			return validStructResistance(psStruct);
+		}
+		// structures with weapons are always worth going for
+		return psStruct->asWeaps[0].nStat > 0
+		       || (psStruct->pStructureType->type != REF_WALL && psStruct->pStructureType->type != REF_WALLCORNER)
+		       || (bMultiPlayer && !isHumanPlayer(psDroid->player));
+	}
+	else if (psDroid->lastFrustratedTime > 0
+	         && gameTime - psDroid->lastFrustratedTime < FRUSTRATED_TIME
+	         && ((FEATURE *)targetInQuestion)->psStats->damageable
+	         && psDroid->player != scavengerPlayer())  // hack to avoid scavs blowing up their nice feature walls
+	{
+		objTrace(psDroid->id, "considering shooting at %s in frustration", objInfo(targetInQuestion));
+		return true;
+	}
+	return false;
+}
 
 // Find the best nearest target for a droid.
 // If extraRange is higher than zero, then this is the range it accepts for movement to target.
@@ -529,7 +760,7 @@ int aiBestNearestTarget(DROID *psDroid, BASE_OBJECT **ppsObj, int weapon_slot, i
 {
 	int failure = -1;
 	int bestMod = 0;
-	BASE_OBJECT                     *psTarget = NULL, *bestTarget = NULL, *tempTarget;
+	BASE_OBJECT                     *bestTarget = NULL, *tempTarget;
 	bool				electronic = false;
 	STRUCTURE			*targetStructure;
 	WEAPON_EFFECT			weaponEffect;
@@ -563,124 +794,79 @@ int aiBestNearestTarget(DROID *psDroid, BASE_OBJECT **ppsObj, int weapon_slot, i
 	// Range was previously 9*TILE_UNITS. Increasing this doesn't seem to help much, though. Not sure why.
 	int droidRange = std::min(aiDroidRange(psDroid, weapon_slot) + extraRange, objSensorRange(psDroid) + 6 * TILE_UNITS);
 
+	// Searches nearest first, so usually stops long before scoring everything in range.
+	std::function<int (BASE_OBJECT *, uint32_t)> score = [&](BASE_OBJECT *psCurr, uint32_t) {
+		if (!aiDroidConsidersTarget(psDroid, psCurr, weapon_slot, electronic, droidRange))
+		{
+			return INT32_MIN;
+		}
+		return targetAttackWeight(psCurr, psDroid, weapon_slot);
+	};
+	std::function<int (int32_t)> maxScore = TargetAttackWeightLimit(psDroid, weapon_slot);
+	int minScore = bestTarget != NULL ? bestMod + 1 : 0;
+	BASE_OBJECT *enemyTarget;
+	if (psDroid->lastFrustratedTime > 0 && gameTime - psDroid->lastFrustratedTime < FRUSTRATED_TIME)
+	{
+		// Might shoot at features, which aren't among the shared candidates.
+		enemyTarget = gridFindBest(psDroid->pos.x, psDroid->pos.y, droidRange, minScore, score, maxScore);
+	}
+	else
+	{
+		GridList const &candidates = aiTargetCandidates(psDroid->player, psDroid->pos.x, psDroid->pos.y, droidRange);
+		enemyTarget = gridFindBestAmong(candidates, psDroid->pos.x, psDroid->pos.y, droidRange, minScore, score, maxScore);
+	}
+	if (enemyTarget != NULL)
+	{
+		bestMod = targetAttackWeight(enemyTarget, psDroid, weapon_slot);
+		tmpOrigin = ORIGIN_VISUAL;
+		bestTarget = enemyTarget;
+	}
+
+	// See if we can reuse the target of a friendly unit we can see. Only the targets themselves are scored, not the friendly units.
 	static GridList gridList;  // static to avoid allocations.
 	gridList = gridStartIterate(psDroid->pos.x, psDroid->pos.y, droidRange);
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
-		BASE_OBJECT *friendlyObj = NULL;
-		BASE_OBJECT *targetInQuestion = *gi;
+		BASE_OBJECT *friendlyObj = *gi;
+		BASE_OBJECT *targetInQuestion = NULL;
 
-		/* This is a friendly unit, check if we can reuse its target */
-		if (aiCheckAlliances(targetInQuestion->player, psDroid->player))
+		if (!aiCheckAlliances(friendlyObj->player, psDroid->player) || friendlyObj->visible[psDroid->player] != UBYTE_MAX)
 		{
-			friendlyObj = targetInQuestion;
-			targetInQuestion = NULL;
+			continue;
+		}
+		if (friendlyObj->type == OBJ_DROID)
+		{
+			DROID	*friendlyDroid = (DROID *)friendlyObj;
 
-			/* Can we see what it is doing? */
-			if (friendlyObj->visible[psDroid->player] == UBYTE_MAX)
+			/* See if friendly droid has a target */
+			tempTarget = friendlyDroid->psActionTarget[0];
+			//make sure a weapon droid is targeting it, and that it wasn't assigned explicitly to this droid
+			if (tempTarget && !tempTarget->died && friendlyDroid->numWeaps > 0 && friendlyDroid->order.type != DORDER_ATTACK)
 			{
-				if (friendlyObj->type == OBJ_DROID)
-				{
-					DROID	*friendlyDroid = (DROID *)friendlyObj;
-
-					/* See if friendly droid has a target */
-					tempTarget = friendlyDroid->psActionTarget[0];
-					if (tempTarget && !tempTarget->died)
-					{
-						//make sure a weapon droid is targeting it
-						if (friendlyDroid->numWeaps > 0)
-						{
-							// make sure this target wasn't assigned explicitly to this droid
-							if (friendlyDroid->order.type != DORDER_ATTACK)
-							{
-								targetInQuestion = tempTarget;  //consider this target
-							}
-						}
-					}
-				}
-				else if (friendlyObj->type == OBJ_STRUCTURE)
-				{
-					tempTarget = ((STRUCTURE *)friendlyObj)->psTarget[0];
-					if (tempTarget && !tempTarget->died)
-					{
-						targetInQuestion = tempTarget;
-					}
-				}
+				targetInQuestion = tempTarget;  //consider this target
 			}
 		}
-
-		if (targetInQuestion != NULL
-		    && targetInQuestion != psDroid  // in case friendly unit had me as target
-		    && (targetInQuestion->type == OBJ_DROID || targetInQuestion->type == OBJ_STRUCTURE || targetInQuestion->type == OBJ_FEATURE)
-		    && targetInQuestion->visible[psDroid->player] == UBYTE_MAX
-		    && !aiCheckAlliances(targetInQuestion->player, psDroid->player)
-		    && validTarget(psDroid, targetInQuestion, weapon_slot)
-		    && objPosDiffSq(psDroid, targetInQuestion) < droidRange * droidRange)
+		else if (friendlyObj->type == OBJ_STRUCTURE)
 		{
-			if (targetInQuestion->type == OBJ_DROID)
+			tempTarget = ((STRUCTURE *)friendlyObj)->psTarget[0];
+			if (tempTarget && !tempTarget->died)
 			{
-				// in multiPlayer - don't attack Transporters with EW
-				if (bMultiPlayer)
-				{
-					// if not electronic then valid target
-					if (!electronic
-					    || (electronic
-					        && !isTransporter((DROID *)targetInQuestion)))
-					{
-						//only a valid target if NOT a transporter
-						psTarget = targetInQuestion;
-					}
-				}
-				else
-				{
-					psTarget = targetInQuestion;
-				}
-			}
-			else if (targetInQuestion->type == OBJ_STRUCTURE)
-			{
-				STRUCTURE *psStruct = (STRUCTURE *)targetInQuestion;
-
-				if (electronic)
-				{
-					/* don't want to target structures with resistance of zero if using electronic warfare */
-					if (validStructResistance((STRUCTURE *)targetInQuestion))
-					{
-						psTarget = targetInQuestion;
-					}
-				}
-				else if (psStruct->asWeaps[0].nStat > 0)
-				{
-					// structure with weapons - go for this
-					psTarget = targetInQuestion;
-				}
-				else if ((psStruct->pStructureType->type != REF_WALL && psStruct->pStructureType->type != REF_WALLCORNER)
-				         || (bMultiPlayer && !isHumanPlayer(psDroid->player)))
-				{
-					psTarget = targetInQuestion;
-				}
-			}
-			else if (targetInQuestion->type == OBJ_FEATURE
-			         && psDroid->lastFrustratedTime > 0
-			         && gameTime - psDroid->lastFrustratedTime < FRUSTRATED_TIME
-			         && ((FEATURE *)targetInQuestion)->psStats->damageable
-			         && psDroid->player != scavengerPlayer())  // hack to avoid scavs blowing up their nice feature walls
-			{
-				psTarget = targetInQuestion;
-				objTrace(psDroid->id, "considering shooting at %s in frustration", objInfo(targetInQuestion));
+				targetInQuestion = tempTarget;
 			}
+		}
 
+		if (targetInQuestion != NULL && targetInQuestion != bestTarget
+		    && aiDroidConsidersTarget(psDroid, targetInQuestion, weapon_slot, electronic, droidRange))
+		{
 			/* Check if our weapon is most effective against this object */
-			if (psTarget != NULL && psTarget == targetInQuestion)		//was assigned?
-			{
-				int newMod = targetAttackWeight(psTarget, (BASE_OBJECT *)psDroid, weapon_slot);
+			int newMod = targetAttackWeight(targetInQuestion, (BASE_OBJECT *)psDroid, weapon_slot);
 
-				/* Remember this one if it's our best target so far */
-				if (newMod >= 0 && (newMod > bestMod || bestTarget == NULL))
-				{
-					bestMod = newMod;
-					tmpOrigin = ORIGIN_ALLY;
-					bestTarget = psTarget;
-				}
+			/* Remember this one if it's our best target so far */
+			if (newMod >= 0 && (newMod > bestMod || bestTarget == NULL))
+			{
+				bestMod = newMod;
+				tmpOrigin = ORIGIN_ALLY;
+				bestTarget = targetInQuestion;
 			}
 		}
 	}
@@ -890,8 +1076,6 @@ bool aiChooseTarget(BASE_OBJECT *psObj, BASE_OBJECT **ppsTarget, int weapon_slot
 
 		if (psTarget == NULL && !bCommanderBlock)
 		{
-			int targetValue = -1;
-			int tarDist = INT32_MAX;
 			int srange = longRange;
 
 			if (!proj_Direct(psWStats) && srange > objSensorRange(psObj))
@@ -901,30 +1085,22 @@ bool aiChooseTarget(BASE_OBJECT *psObj, BASE_OBJECT **ppsTarget, int weapon_slot
 				srange = objSensorRange(psObj);
 			}
 
-			static GridList gridList;  // static to avoid allocations.
-			gridList = gridStartIterate(psObj->pos.x, psObj->pos.y, srange);
-			for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
-			{
-				BASE_OBJECT *psCurr = *gi;
+			// Searches nearest first, so usually stops long before checking the line of fire to everything in range.
+			GridList const &candidates = aiTargetCandidates(psObj->player, psObj->pos.x, psObj->pos.y, srange);
+			psTarget = gridFindBestAmong(candidates, psObj->pos.x, psObj->pos.y, srange, -1, [&](BASE_OBJECT *psCurr, uint32_t) {
 				/* Check that it is a valid target */
 				if (psCurr->type != OBJ_FEATURE && !psCurr->died
 				    && !aiCheckAlliances(psCurr->player, psObj->player)
 				    && validTarget(psObj, psCurr, weapon_slot) && psCurr->visible[psObj->player] == UBYTE_MAX
 				    && aiStructHasRange((STRUCTURE *)psObj, psCurr, weapon_slot))
 				{
-					int newTargetValue = targetAttackWeight(psCurr, psObj, weapon_slot);
-					// See if in sensor range and visible
-					int distSq = objPosDiffSq(psCurr->pos, psObj->pos);
-					if (newTargetValue < targetValue || (newTargetValue == targetValue && distSq >= tarDist))
-					{
-						continue;
-					}
-
-					tmpOrigin = ORIGIN_VISUAL;
-					psTarget = psCurr;
-					tarDist = distSq;
-					targetValue = newTargetValue;
+					return targetAttackWeight(psCurr, psObj, weapon_slot);
 				}
+				return INT32_MIN;
+			}, TargetAttackWeightLimit((STRUCTURE *)psObj, weapon_slot));
+			if (psTarget != NULL)
+			{
+				tmpOrigin = ORIGIN_VISUAL;
 			}
 		}
 
@@ -981,32 +1157,13 @@ bool aiChooseSensorTarget(BASE_OBJECT *psObj, BASE_OBJECT **ppsTarget)
 	}
 	else	// structure
 	{
-		BASE_OBJECT    *psTemp = NULL;
-		int		tarDist = SDWORD_MAX;
-
-		static GridList gridList;  // static to avoid allocations.
-		gridList = gridStartIterate(psObj->pos.x, psObj->pos.y, objSensorRange(psObj));
-		for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
-		{
-			BASE_OBJECT *psCurr = *gi;
-			// Don't target features or doomed/dead objects
-			if (psCurr->type != OBJ_FEATURE && !psCurr->died && !aiObjectIsProbablyDoomed(psCurr, false))
-			{
-				if (!aiCheckAlliances(psCurr->player, psObj->player) && !aiObjIsWall(psCurr))
-				{
-					// See if in sensor range and visible
-					const int xdiff = psCurr->pos.x - psObj->pos.x;
-					const int ydiff = psCurr->pos.y - psObj->pos.y;
-					const unsigned int distSq = xdiff * xdiff + ydiff * ydiff;
-
-					if (distSq < radSquared && psCurr->visible[psObj->player] == UBYTE_MAX && distSq < tarDist)
-					{
-						psTemp = psCurr;
-						tarDist = distSq;
-					}
-				}
-			}
-		}
+		GridList const &gridList = gridStartIterateNearest(psObj->pos.x, psObj->pos.y, sensorRange, 1, [&](BASE_OBJECT *psCurr, uint32_t distSq) {
+			// Don't target features or doomed/dead objects, and see if in sensor range and visible
+			return psCurr->type != OBJ_FEATURE && !psCurr->died && !aiObjectIsProbablyDoomed(psCurr, false)
+			       && !aiCheckAlliances(psCurr->player, psObj->player) && !aiObjIsWall(psCurr)
+			       && distSq < radSquared && psCurr->visible[psObj->player] == UBYTE_MAX;
+		});
+		BASE_OBJECT *psTemp = gridList.empty() ? NULL : gridList[0];
 
 		if (psTemp)
 		{
@@ -1060,7 +1217,7 @@ static bool updateAttackTarget(BASE_OBJECT *psAttacker, SDWORD weapon_slot)
 void aiUpdateDroid(DROID *psDroid)
 {
 	BASE_OBJECT	*psTarget;
-	bool		lookForTarget, updateTarget;
+	bool		lookForTarget, updateTarget, lostTarget;
 
 	ASSERT(psDroid != NULL, "Invalid droid pointer");
 	if (!psDroid || isDead((BASE_OBJECT *)psDroid))
@@ -1075,6 +1232,7 @@ void aiUpdateDroid(DROID *psDroid)
 
 	lookForTarget = false;
 	updateTarget = false;
+	lostTarget = false;
 
 	// look for a target if doing nothing
 	if (orderState(psDroid, DORDER_NONE) ||
@@ -1108,6 +1266,7 @@ void aiUpdateDroid(DROID *psDroid)
 	{
 		lookForTarget = true;
 		updateTarget = false;
+		lostTarget = true;
 	}
 
 	/* Don't update target if we are sent to attack and reached attack destination (attacking our target) */
@@ -1151,7 +1310,7 @@ void aiUpdateDroid(DROID *psDroid)
 
 	/* For commanders and non-assigned non-commanders: look for a better target once in a while */
 	if (!lookForTarget && updateTarget && psDroid->numWeaps > 0 && !hasCommander(psDroid)
-	    && (psDroid->id + gameTime) / TARGET_UPD_SKIP_FRAMES != (psDroid->id + gameTime - deltaGameTime) / TARGET_UPD_SKIP_FRAMES)
+	    && aiTargetSearchDue(psDroid, TARGET_UPD_SKIP_FRAMES, false))
 	{
 		for (int i = 0; i < psDroid->numWeaps; ++i)
 		{
@@ -1161,7 +1320,7 @@ void aiUpdateDroid(DROID *psDroid)
 
 	/* Null target - see if there is an enemy to attack */
 
-	if (lookForTarget && !updateTarget)
+	if (lookForTarget && !updateTarget && aiTargetSearchDue(psDroid, TARGET_SEARCH_INTERVAL, lostTarget))
 	{
 		if (psDroid->droidType == DROID_SENSOR)
 		{
@@ -26,6 +26,7 @@
 
 struct BASE_OBJECT;
 struct DROID;
+struct STRUCTURE;
 
 #include "weapondef.h"
 
@@ -80,6 +81,15 @@ void aiObjectAddExpectedDamage(BASE_OBJECT *psObject, SDWORD damage, bool isDire
 bool aiChooseTarget(BASE_OBJECT *psObj,
                     BASE_OBJECT **ppsTarget, int weapon_slot, bool bUpdateTarget, TARGET_ORIGIN *targetOrigin);
 
+/** How often idle objects, and structures which already have a target, look for a (better) target, in milliseconds. */
+#define TARGET_SEARCH_INTERVAL 300
+
+/** Whether psObj should search for a target this tick, limiting the number of searches per tick. Marks psObj as having searched, if so. */
+bool aiTargetSearchDue(BASE_OBJECT *psObj, unsigned interval, bool urgent);
+
+/** Whether the structure can keep shooting at its current target, without searching for a better one. */
+bool aiStructCanKeepTarget(STRUCTURE *psStruct, int weapon_slot);
+
 /** See if there is a target in range for Sensor objects. */
 bool aiChooseSensorTarget(BASE_OBJECT *psObj, BASE_OBJECT **ppsTarget);
 
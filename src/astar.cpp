@@ -35,9 +35,16 @@
  *    is continued until the new source is reached.  If the new source is  not reached,
  *    the droid is  on a  different island than the previous droid,  and pathfinding is
  *    restarted from the first step.
- *  Up to 30 pathfinding maps from A* are cached, in a LRU list. The PathNode heap con-
- *  tains the  priority-heap-sorted  nodes which are to be explored.  The path back  is
- *  stored in the PathExploredTile 2D array of tiles.
+ *  Pathfinding maps from A* are  cached in a few LRU lists, one for  each thread which
+ *  may be pathfinding. The PathNode heap contains the priority-heap-sorted nodes which
+ *  are to be explored. The path back is stored in the PathExploredTile 2D array.
+ *  * Long routes, with no appropriate Context, are first found on an abstract graph of
+ *    the map. The map is split into sectors of FPATH_SECTOR_SIZE×FPATH_SECTOR_SIZE tiles,
+ *    and the graph has an entrance node for each opening between neighbouring sectors,
+ *    with the distances between the entrances of each sector precomputed.  The A* al-
+ *    gorithm is then only allowed to explore the sectors the abstract route goes through.
+ *    The graph is  kept with each blocking map,  and only the  sectors which changed are
+ *    recomputed when the blocking map is regenerated.
  */
 
 #ifndef WZ_TESTING
@@ -51,6 +58,7 @@
 #include <vector>
 #include <algorithm>
 #include <memory>
+#include <unordered_map>
 
 #include "lib/netplay/netplay.h"
 
@@ -116,6 +124,30 @@ struct PathBlockingType
 	int owner;
 	FPATH_MOVETYPE moveType;
 };
+/// Size of the sectors of the abstract graph used for long routes, in tiles.
+#define FPATH_SECTOR_SIZE 16
+
+/// Routes between tiles closer than this many sectors apart are found using A* only.
+static const int fpathSectorMinRoute = 2;
+
+/// Entrances of a sector of the map, for finding long routes.
+struct PathSector
+{
+	struct Entrance
+	{
+		PathCoord tile;                 ///< Tile in this sector, next to the edge of the sector.
+		PathCoord partner;              ///< Neighbouring tile on the other side of the edge, in the neighbouring sector.
+	};
+
+	unsigned distance(unsigned from, unsigned to) const
+	{
+		return dist[from + to * entrances.size()];
+	}
+
+	std::vector<Entrance> entrances;
+	std::vector<unsigned> dist;         ///< Distances between the entrances, moving only within the sector. UINT_MAX if unreachable.
+};
+
 /// Pathfinding blocking map
 struct PathBlockingMap
 {
@@ -126,9 +158,31 @@ struct PathBlockingMap
 		                                 z.propulsion,    z.owner,    z.moveType);
 	}
 
+	bool isBlocked(int x, int y) const
+	{
+		return x < 0 || y < 0 || x >= width || y >= height || testBit(map, x + y * width);
+	}
+	bool isDangerous(int x, int y) const
+	{
+		return !dangerMap.empty() && testBit(dangerMap, x + y * width);
+	}
+	static bool testBit(std::vector<uint64_t> const &bits, unsigned i)
+	{
+		return (bits[i / 64] >> i % 64 & 1) != 0;
+	}
+
 	PathBlockingType type;
-	std::vector<bool> map;
-	std::vector<bool> dangerMap;	// using threatBits
+	std::vector<uint64_t> map;          ///< One bit per tile, set if blocking.
+	std::vector<uint64_t> dangerMap;    ///< One bit per tile, set if threatened, using threatBits. Empty if not used.
+	uint32_t hash, dangerHash;          ///< Running hashes of the bits set in map and dangerMap, for syncDebug.
+	int width, height;                  ///< Size of the map the blocking map was generated for.
+	int scrollMinX, scrollMinY, scrollMaxX, scrollMaxY;  ///< Scroll limits the blocking map was generated for.
+	uint32_t auxGeneration;             ///< auxMapGeneration when the blocking map was generated.
+	size_t auxChanges;                  ///< Number of aux map changes already included in the blocking map, counting from the start of the game.
+	int dangerOwner;                    ///< Player whose threat bits are in dangerMap.
+	uint32_t threatChanges;             ///< auxThreatChanges[dangerOwner] when dangerMap was generated.
+	int sectorsX, sectorsY;
+	std::vector<std::shared_ptr<PathSector const>> sectors;  ///< Abstract graph for long routes. Unchanged sectors are shared with older maps.
 };
 
 struct PathNonblockingArea
@@ -162,11 +216,15 @@ struct PathfindContext
 			return false;  // The path is actually blocked here by a structure, but ignore it since it's where we want to go (or where we came from).
 		}
 		// Not sure whether the out-of-bounds check is needed, can only happen if pathfinding is started on a blocking tile (or off the map).
-		return x < 0 || y < 0 || x >= mapWidth || y >= mapHeight || blockingMap->map[x + y * mapWidth];
+		return blockingMap->isBlocked(x, y) || !inCorridor(x, y);
+	}
+	bool inCorridor(int x, int y) const
+	{
+		return corridor.empty() || corridor[x / FPATH_SECTOR_SIZE + y / FPATH_SECTOR_SIZE * blockingMap->sectorsX];
 	}
 	bool isDangerous(int x, int y) const
 	{
-		return !blockingMap->dangerMap.empty() && blockingMap->dangerMap[x + y * mapWidth];
+		return blockingMap->isDangerous(x, y);
 	}
 	bool matches(std::shared_ptr<PathBlockingMap> &blockingMap_, PathCoord tileS_, PathNonblockingArea dstIgnore_) const
 	{
@@ -205,13 +263,25 @@ struct PathfindContext
 	std::vector<PathExploredTile> map;  ///< Map, with paths leading back to tileS.
 	std::shared_ptr<PathBlockingMap> blockingMap; ///< Map of blocking tiles for the type of object which needs a path.
 	PathNonblockingArea dstIgnore;      ///< Area of structure at destination which should be considered nonblocking.
+	std::vector<bool> corridor;         ///< Sectors which may be explored, from the abstract route. Empty if the whole map may be explored.
 };
 
-/// Last recently used list of contexts.
-static std::list<PathfindContext> fpathContexts;
+/// Pathfinding data which can only be used by one thread at a time.
+struct PathfindCache
+{
+	std::list<PathfindContext> contexts;  ///< Last recently used list of contexts.
+	std::vector<Vector2i> path;           ///< Route being returned. Kept to save allocations.
+};
+
+/// Maximum number of contexts in each PathfindCache.
+static const size_t fpathMaxContexts = 4;
+
+static PathfindCache fpathCaches[FPATH_CONTEXT_CACHES];
 
 /// Lists of blocking maps from current tick.
 static std::vector<std::shared_ptr<PathBlockingMap>> fpathBlockingMaps;
+/// Most recent blocking map of each type, for updating instead of regenerating.
+static std::vector<std::shared_ptr<PathBlockingMap>> fpathLastBlockingMaps;
 /// Game time for all blocking maps in fpathBlockingMaps.
 static uint32_t fpathCurrentGameTime;
 
@@ -231,8 +301,12 @@ static const Vector2i aDirOffset[] =
 
 void fpathHardTableReset()
 {
-	fpathContexts.clear();
+	for (unsigned i = 0; i < FPATH_CONTEXT_CACHES; ++i)
+	{
+		fpathCaches[i].contexts.clear();
+	}
 	fpathBlockingMaps.clear();
+	fpathLastBlockingMaps.clear();
 }
 
 /** Get the nearest entry in the open list
@@ -438,6 +512,278 @@ static void fpathInitContext(PathfindContext &context, std::shared_ptr<PathBlock
 	ASSERT(!context.nodes.empty(), "fpathNewNode failed to add node.");
 }
 
+/// Finds the distances from the tile from to each tile of a sector, moving only within the sector. Unreachable tiles get UINT_MAX.
+static void fpathSectorDistances(PathBlockingMap const &blockingMap, PathNonblockingArea const &dstIgnore, int sectorX, int sectorY, PathCoord from, unsigned *dist)
+{
+	const int x0 = sectorX * FPATH_SECTOR_SIZE, x1 = std::min(x0 + FPATH_SECTOR_SIZE, mapWidth);
+	const int y0 = sectorY * FPATH_SECTOR_SIZE, y1 = std::min(y0 + FPATH_SECTOR_SIZE, mapHeight);
+	auto isBlocked = [&](int x, int y) {
+		return !dstIgnore.isNonblocking(x, y) && blockingMap.isBlocked(x, y);
+	};
+
+	typedef std::pair<unsigned, unsigned> Item;  // Distance and tile, in sector coordinates.
+	std::vector<Item> heap;
+	std::fill(dist, dist + FPATH_SECTOR_SIZE * FPATH_SECTOR_SIZE, UINT_MAX);
+	dist[from.x - x0 + (from.y - y0) * FPATH_SECTOR_SIZE] = 0;
+	heap.push_back(Item(0, from.x - x0 + (from.y - y0) * FPATH_SECTOR_SIZE));
+	while (!heap.empty())
+	{
+		std::pop_heap(heap.begin(), heap.end(), std::greater<Item>());
+		Item item = heap.back();
+		heap.pop_back();
+		if (item.first != dist[item.second])
+		{
+			continue;  // Already found a shorter way here.
+		}
+		const int x = x0 + item.second % FPATH_SECTOR_SIZE, y = y0 + item.second / FPATH_SECTOR_SIZE;
+		for (unsigned dir = 0; dir < ARRAY_SIZE(aDirOffset); ++dir)
+		{
+			const int nx = x + aDirOffset[dir].x, ny = y + aDirOffset[dir].y;
+			if (nx < x0 || ny < y0 || nx >= x1 || ny >= y1 || isBlocked(nx, ny))
+			{
+				continue;
+			}
+			// We cannot cut corners, same as in fpathAStarExplore.
+			if (dir % 2 != 0 && !dstIgnore.isNonblocking(x, y) && !dstIgnore.isNonblocking(nx, ny)
+			    && (isBlocked(x + aDirOffset[(dir + 1) % 8].x, y + aDirOffset[(dir + 1) % 8].y) || isBlocked(x + aDirOffset[(dir + 7) % 8].x, y + aDirOffset[(dir + 7) % 8].y)))
+			{
+				continue;
+			}
+			const unsigned n = nx - x0 + (ny - y0) * FPATH_SECTOR_SIZE;
+			const unsigned d = item.first + (dir % 2 != 0 ? 198 : 140);
+			if (d < dist[n])
+			{
+				dist[n] = d;
+				heap.push_back(Item(d, n));
+				std::push_heap(heap.begin(), heap.end(), std::greater<Item>());
+			}
+		}
+	}
+}
+
+/// Finds the entrances of a sector, and the distances between them.
+static std::shared_ptr<PathSector const> fpathBuildSector(PathBlockingMap const &blockingMap, int sectorX, int sectorY)
+{
+	const int x0 = sectorX * FPATH_SECTOR_SIZE, x1 = std::min(x0 + FPATH_SECTOR_SIZE, mapWidth);
+	const int y0 = sectorY * FPATH_SECTOR_SIZE, y1 = std::min(y0 + FPATH_SECTOR_SIZE, mapHeight);
+	std::shared_ptr<PathSector> sector = std::make_shared<PathSector>();
+
+	// Each opening along an edge gets one entrance, in the middle of the opening. The neighbouring sector finds the same openings, so gets the partner entrances.
+	struct Edge
+	{
+		bool exists;
+		Vector2i start, step, out;
+		int length;
+	};
+	const Edge edges[] =
+	{
+		{y0 > 0,         Vector2i(x0, y0),     Vector2i(1, 0), Vector2i(0, -1), x1 - x0},
+		{y1 < mapHeight, Vector2i(x0, y1 - 1), Vector2i(1, 0), Vector2i(0, 1),  x1 - x0},
+		{x0 > 0,         Vector2i(x0, y0),     Vector2i(0, 1), Vector2i(-1, 0), y1 - y0},
+		{x1 < mapWidth,  Vector2i(x1 - 1, y0), Vector2i(0, 1), Vector2i(1, 0),  y1 - y0},
+	};
+	for (unsigned e = 0; e < ARRAY_SIZE(edges); ++e)
+	{
+		Edge const &edge = edges[e];
+		int openingStart = -1;
+		for (int i = 0; edge.exists && i <= edge.length; ++i)
+		{
+			Vector2i tile = edge.start + edge.step * i;
+			Vector2i partner = tile + edge.out;
+			bool open = i < edge.length && !blockingMap.isBlocked(tile.x, tile.y) && !blockingMap.isBlocked(partner.x, partner.y);
+			if (open && openingStart < 0)
+			{
+				openingStart = i;
+			}
+			else if (!open && openingStart >= 0)
+			{
+				Vector2i middle = edge.start + edge.step * ((openingStart + i - 1) / 2);
+				PathSector::Entrance entrance;
+				entrance.tile = PathCoord(middle.x, middle.y);
+				entrance.partner = PathCoord(middle.x + edge.out.x, middle.y + edge.out.y);
+				sector->entrances.push_back(entrance);
+				openingStart = -1;
+			}
+		}
+	}
+
+	const PathNonblockingArea noArea(StructureBounds(Vector2i(0, 0), Vector2i(0, 0)));
+	const unsigned numEntrances = sector->entrances.size();
+	unsigned dist[FPATH_SECTOR_SIZE * FPATH_SECTOR_SIZE];
+	sector->dist.resize(numEntrances * numEntrances);
+	for (unsigned i = 0; i < numEntrances; ++i)
+	{
+		fpathSectorDistances(blockingMap, noArea, sectorX, sectorY, sector->entrances[i].tile, dist);
+		for (unsigned j = 0; j < numEntrances; ++j)
+		{
+			PathCoord tile = sector->entrances[j].tile;
+			sector->dist[i + j * numEntrances] = dist[tile.x - x0 + (tile.y - y0) * FPATH_SECTOR_SIZE];
+		}
+	}
+	return sector;
+}
+
+/** Regenerates the sectors of a new blocking map which changed since the previous map of the same type.
+ *  If prevMap is NULL, all the sectors are generated, otherwise changedTiles lists the tiles which differ from prevMap.
+ */
+static void fpathUpdateSectors(PathBlockingMap &blockingMap, PathBlockingMap const *prevMap, std::vector<unsigned> const &changedTiles)
+{
+	blockingMap.sectorsX = (blockingMap.width + FPATH_SECTOR_SIZE - 1) / FPATH_SECTOR_SIZE;
+	blockingMap.sectorsY = (blockingMap.height + FPATH_SECTOR_SIZE - 1) / FPATH_SECTOR_SIZE;
+	blockingMap.sectors.resize(blockingMap.sectorsX * blockingMap.sectorsY);
+
+	std::vector<bool> changed(blockingMap.sectors.size(), prevMap == NULL);
+	for (unsigned tile : changedTiles)
+	{
+		int x = tile % blockingMap.width, y = tile / blockingMap.width;
+		changed[x / FPATH_SECTOR_SIZE + y / FPATH_SECTOR_SIZE * blockingMap.sectorsX] = true;
+	}
+
+	int rebuilt = 0;
+	for (int sy = 0; sy < blockingMap.sectorsY; ++sy)
+		for (int sx = 0; sx < blockingMap.sectorsX; ++sx)
+		{
+			// The entrances also depend on the tiles along the edges of the neighbouring sectors.
+			const int s = sx + sy * blockingMap.sectorsX;
+			if (changed[s] || (sx > 0 && changed[s - 1]) || (sx + 1 < blockingMap.sectorsX && changed[s + 1])
+			    || (sy > 0 && changed[s - blockingMap.sectorsX]) || (sy + 1 < blockingMap.sectorsY && changed[s + blockingMap.sectorsX]))
+			{
+				blockingMap.sectors[s] = fpathBuildSector(blockingMap, sx, sy);
+				++rebuilt;
+			}
+			else
+			{
+				blockingMap.sectors[s] = prevMap->sectors[s];
+			}
+		}
+	debug(LOG_NEVER, "Regenerated %d of %d sectors", rebuilt, (int)blockingMap.sectors.size());
+}
+
+/** Finds a route from tileOrig to tileDest on the abstract graph, and marks the sectors it goes through in corridor.
+ *  Returns false if the route is too short to be worth it, or if no route was found.
+ */
+static bool fpathFindCorridor(PathBlockingMap const &blockingMap, PathNonblockingArea const &dstIgnore, PathCoord tileOrig, PathCoord tileDest, std::vector<bool> &corridor)
+{
+	const int origSector = tileOrig.x / FPATH_SECTOR_SIZE + tileOrig.y / FPATH_SECTOR_SIZE * blockingMap.sectorsX;
+	const int destSector = tileDest.x / FPATH_SECTOR_SIZE + tileDest.y / FPATH_SECTOR_SIZE * blockingMap.sectorsX;
+	if (abs(tileOrig.x / FPATH_SECTOR_SIZE - tileDest.x / FPATH_SECTOR_SIZE) < fpathSectorMinRoute
+	    && abs(tileOrig.y / FPATH_SECTOR_SIZE - tileDest.y / FPATH_SECTOR_SIZE) < fpathSectorMinRoute)
+	{
+		return false;
+	}
+
+	// Distances from orig and to dest, within their sectors.
+	unsigned origDist[FPATH_SECTOR_SIZE * FPATH_SECTOR_SIZE], destDist[FPATH_SECTOR_SIZE * FPATH_SECTOR_SIZE];
+	fpathSectorDistances(blockingMap, dstIgnore, tileOrig.x / FPATH_SECTOR_SIZE, tileOrig.y / FPATH_SECTOR_SIZE, tileOrig, origDist);
+	fpathSectorDistances(blockingMap, dstIgnore, tileDest.x / FPATH_SECTOR_SIZE, tileDest.y / FPATH_SECTOR_SIZE, tileDest, destDist);
+	auto sectorTile = [](PathCoord tile) {
+		return tile.x % FPATH_SECTOR_SIZE + tile.y % FPATH_SECTOR_SIZE * FPATH_SECTOR_SIZE;
+	};
+
+	// A* on the abstract graph. Each entrance is identified by its sector * 256 + its index in the sector.
+	struct Node
+	{
+		bool operator <(Node const &z) const
+		{
+			// Sort decending est, fallback to ascending dist, fallback to sorting by id, same as PathNode.
+			if (est != z.est)
+			{
+				return est > z.est;
+			}
+			if (dist != z.dist)
+			{
+				return dist < z.dist;
+			}
+			return id < z.id;
+		}
+
+		unsigned id, dist, est;
+	};
+	const unsigned origId = UINT_MAX - 1, destId = UINT_MAX;
+	std::vector<Node> nodes;
+	std::unordered_map<unsigned, std::pair<unsigned, unsigned>> explored;  // Shortest known distance and previous entrance, for each entrance.
+	auto addNode = [&](unsigned id, PathCoord tile, unsigned dist, unsigned prevId) {
+		auto i = explored.find(id);
+		if (i != explored.end() && i->second.first <= dist)
+		{
+			return;  // A different route to this entrance is shorter.
+		}
+		explored[id] = std::make_pair(dist, prevId);
+		Node node = {id, dist, dist + fpathEstimate(tile, tileDest)};
+		nodes.push_back(node);
+		std::push_heap(nodes.begin(), nodes.end());
+	};
+
+	PathSector const &origEntrances = *blockingMap.sectors[origSector];
+	for (unsigned i = 0; i < origEntrances.entrances.size(); ++i)
+	{
+		unsigned dist = origDist[sectorTile(origEntrances.entrances[i].tile)];
+		if (dist != UINT_MAX)
+		{
+			addNode(origSector * 256 + i, origEntrances.entrances[i].tile, dist, origId);
+		}
+	}
+
+	bool foundIt = false;
+	while (!nodes.empty())
+	{
+		std::pop_heap(nodes.begin(), nodes.end());
+		Node node = nodes.back();
+		nodes.pop_back();
+		if (node.dist != explored[node.id].first)
+		{
+			continue;  // Already been here.
+		}
+		if (node.id == destId)
+		{
+			foundIt = true;
+			break;
+		}
+
+		const unsigned s = node.id / 256, i = node.id % 256;
+		PathSector const &sector = *blockingMap.sectors[s];
+		if (s == (unsigned)destSector)
+		{
+			unsigned dist = destDist[sectorTile(sector.entrances[i].tile)];
+			if (dist != UINT_MAX)
+			{
+				addNode(destId, tileDest, node.dist + dist, node.id);
+			}
+		}
+		for (unsigned j = 0; j < sector.entrances.size(); ++j)
+		{
+			unsigned dist = sector.distance(i, j);
+			if (j != i && dist != UINT_MAX)
+			{
+				addNode(s * 256 + j, sector.entrances[j].tile, node.dist + dist, node.id);
+			}
+		}
+		PathCoord partner = sector.entrances[i].partner;
+		const unsigned t = partner.x / FPATH_SECTOR_SIZE + partner.y / FPATH_SECTOR_SIZE * blockingMap.sectorsX;
+		PathSector const &neighbour = *blockingMap.sectors[t];
+		for (unsigned j = 0; j < neighbour.entrances.size(); ++j)
+		{
+			if (neighbour.entrances[j].tile == partner)
+			{
+				addNode(t * 256 + j, partner, node.dist + 140, node.id);
+				break;
+			}
+		}
+	}
+	if (!foundIt)
+	{
+		return false;  // Destination not reachable, or only through the area of the destination structure.
+	}
+
+	corridor.assign(blockingMap.sectors.size(), false);
+	corridor[origSector] = true;
+	for (unsigned id = explored[destId].second; id != origId; id = explored[id].second)
+	{
+		corridor[id / 256] = true;
+	}
+	return true;
+}
+
 ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 {
 	ASR_RETVAL      retval = ASR_OK;
@@ -450,6 +796,9 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 
 	PathCoord endCoord;  // Either nearest coord (mustReverse = true) or orig (mustReverse = false).
 
+	ASSERT_OR_RETURN(ASR_FAILED, psJob->contextCache < FPATH_CONTEXT_CACHES, "Bad context cache %u", psJob->contextCache);
+	std::list<PathfindContext> &fpathContexts = fpathCaches[psJob->contextCache].contexts;
+
 	std::list<PathfindContext>::iterator contextIterator = fpathContexts.begin();
 	for (contextIterator = fpathContexts.begin(); contextIterator != fpathContexts.end(); ++contextIterator)
 	{
@@ -458,6 +807,11 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 			// This context is not for the same droid type and same destination.
 			continue;
 		}
+		if (!contextIterator->inCorridor(tileOrig.x, tileOrig.y))
+		{
+			// This context may only explore the sectors along the route from somewhere else.
+			continue;
+		}
 
 		// We have tried going to tileDest before.
 
@@ -488,7 +842,7 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 	{
 		// We did not find an appropriate context. Make one.
 
-		if (fpathContexts.size() < 30)
+		if (fpathContexts.size() < fpathMaxContexts)
 		{
 			fpathContexts.push_back(PathfindContext());
 		}
@@ -496,8 +850,18 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 
 		// Init a new context, overwriting the oldest one if we are caching too many.
 		// We will be searching from orig to dest, since we don't know where the nearest reachable tile to dest is.
+		// For long routes, only search the sectors along the route on the abstract graph.
+		contextIterator->corridor.clear();
+		fpathFindCorridor(*psJob->blockingMap, dstIgnore, tileOrig, tileDest, contextIterator->corridor);
 		fpathInitContext(*contextIterator, psJob->blockingMap, tileOrig, tileOrig, tileDest, dstIgnore);
 		endCoord = fpathAStarExplore(*contextIterator, tileDest);
+		if (endCoord != tileDest && !contextIterator->corridor.empty())
+		{
+			// Can only happen if the route goes through the area of the destination structure, outside the sector of the destination. Search everywhere instead.
+			contextIterator->corridor.clear();
+			fpathInitContext(*contextIterator, psJob->blockingMap, tileOrig, tileOrig, tileDest, dstIgnore);
+			endCoord = fpathAStarExplore(*contextIterator, tileDest);
+		}
 		contextIterator->nearestCoord = endCoord;
 	}
 
@@ -510,7 +874,7 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 	}
 
 	// Get route, in reverse order.
-	static std::vector<Vector2i> path;  // Declared static to save allocations.
+	std::vector<Vector2i> &path = fpathCaches[psJob->contextCache].path;
 	path.clear();
 
 	Vector2i newP;
@@ -561,7 +925,7 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 	ASSERT(psMove->asPath, "Out of memory");
 	if (!psMove->asPath)
 	{
-		fpathHardTableReset();
+		fpathContexts.clear();
 		return ASR_FAILED;
 	}
 
@@ -604,6 +968,38 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 	return retval;
 }
 
+/// Hash of a tile index, the hashes of the set bits of a blocking map are XORed together, so that single bits can be updated.
+static inline uint32_t fpathTileHash(unsigned i)
+{
+	uint32_t h = i + 1;
+	h ^= h >> 16;
+	h *= 0x85EBCA6B;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35;
+	h ^= h >> 16;
+	return h;
+}
+
+/// Sets the bits of bits where tileBit is true, and returns the hash of the set bits.
+template<typename F>
+static uint32_t fpathFillBits(std::vector<uint64_t> &bits, F tileBit)
+{
+	const unsigned size = mapWidth * mapHeight;
+	uint32_t hash = 0;
+	bits.assign((size + 63) / 64, 0);
+	for (int y = 0; y < mapHeight; ++y)
+		for (int x = 0; x < mapWidth; ++x)
+		{
+			if (tileBit(x, y))
+			{
+				unsigned i = x + y * mapWidth;
+				bits[i / 64] |= (uint64_t)1 << i % 64;
+				hash ^= fpathTileHash(i);
+			}
+		}
+	return hash;
+}
+
 void fpathSetBlockingMap(PATHJOB *psJob)
 {
 	if (fpathCurrentGameTime != gameTime)
@@ -611,6 +1007,17 @@ void fpathSetBlockingMap(PATHJOB *psJob)
 		// New tick, remove maps which are no longer needed.
 		fpathCurrentGameTime = gameTime;
 		fpathBlockingMaps.clear();
+
+		// Forget the aux map changes which all the blocking maps already include.
+		size_t needChanges = auxChangedTilesStart + auxChangedTiles.size();
+		for (auto const &last : fpathLastBlockingMaps)
+		{
+			if (last->auxGeneration == auxMapGeneration)
+			{
+				needChanges = std::min(needChanges, last->auxChanges);
+			}
+		}
+		auxForgetChanges(needChanges);
 	}
 
 	// Figure out which map we are looking for.
@@ -632,27 +1039,87 @@ void fpathSetBlockingMap(PATHJOB *psJob)
 
 		// blockMap now points to an empty map with no data. Fill the map.
 		blockMap->type = type;
-		std::vector<bool> &map = blockMap->map;
-		map.resize(mapWidth * mapHeight);
-		uint32_t checksumMap = 0, checksumDangerMap = 0, factor = 0;
-		for (int y = 0; y < mapHeight; ++y)
-			for (int x = 0; x < mapWidth; ++x)
+		blockMap->width = mapWidth;
+		blockMap->height = mapHeight;
+		blockMap->scrollMinX = scrollMinX;
+		blockMap->scrollMinY = scrollMinY;
+		blockMap->scrollMaxX = scrollMaxX;
+		blockMap->scrollMaxY = scrollMaxY;
+		blockMap->auxGeneration = auxMapGeneration;
+		blockMap->auxChanges = auxChangedTilesStart + auxChangedTiles.size();
+
+		// Find the last map of this type. If the aux map changes since then are still known, only the changed tiles need to be looked at.
+		auto last = std::find_if(fpathLastBlockingMaps.begin(), fpathLastBlockingMaps.end(), [&](std::shared_ptr<PathBlockingMap> const &ptr) {
+			return fpathIsEquivalentBlocking(ptr->type.propulsion, ptr->type.owner, ptr->type.moveType,
+			                                 type.propulsion,      type.owner,      type.moveType);
+		});
+		PathBlockingMap const *prevMap = NULL;
+		if (last != fpathLastBlockingMaps.end())
+		{
+			PathBlockingMap const *lastMap = last->get();
+			if (lastMap->auxGeneration == blockMap->auxGeneration && lastMap->auxChanges >= auxChangedTilesStart
+			    && lastMap->width == blockMap->width && lastMap->height == blockMap->height
+			    && lastMap->scrollMinX == blockMap->scrollMinX && lastMap->scrollMinY == blockMap->scrollMinY
+			    && lastMap->scrollMaxX == blockMap->scrollMaxX && lastMap->scrollMaxY == blockMap->scrollMaxY)
 			{
-				map[x + y * mapWidth] = fpathBaseBlockingTile(x, y, type.propulsion, type.owner, type.moveType);
-				checksumMap ^= map[x + y * mapWidth] * (factor = 3 * factor + 1);
+				prevMap = lastMap;
 			}
-		if (!isHumanPlayer(type.owner) && type.moveType == FMT_MOVE)
+		}
+
+		std::vector<unsigned> changedTiles;
+		if (prevMap != NULL)
 		{
-			std::vector<bool> &dangerMap = blockMap->dangerMap;
-			dangerMap.resize(mapWidth * mapHeight);
-			for (int y = 0; y < mapHeight; ++y)
-				for (int x = 0; x < mapWidth; ++x)
+			blockMap->map = prevMap->map;
+			blockMap->hash = prevMap->hash;
+			for (auto tile = auxChangedTiles.begin() + (prevMap->auxChanges - auxChangedTilesStart); tile != auxChangedTiles.end(); ++tile)
+			{
+				unsigned i = *tile;
+				bool blocking = fpathBaseBlockingTile(i % mapWidth, i / mapWidth, type.propulsion, type.owner, type.moveType);
+				if (blocking != PathBlockingMap::testBit(blockMap->map, i))
 				{
-					dangerMap[x + y * mapWidth] = auxTile(x, y, type.owner) & AUXBITS_THREAT;
-					checksumDangerMap ^= dangerMap[x + y * mapWidth] * (factor = 3 * factor + 1);
+					blockMap->map[i / 64] ^= (uint64_t)1 << i % 64;
+					blockMap->hash ^= fpathTileHash(i);
+					changedTiles.push_back(i);
 				}
+			}
+		}
+		else
+		{
+			blockMap->hash = fpathFillBits(blockMap->map, [&](int x, int y) {
+				return fpathBaseBlockingTile(x, y, type.propulsion, type.owner, type.moveType);
+			});
+		}
+
+		blockMap->dangerOwner = type.owner;
+		blockMap->dangerHash = 0;
+		if (!isHumanPlayer(type.owner) && type.moveType == FMT_MOVE)
+		{
+			// The threat bits are only updated all at once, when the danger map thread finishes, so just check whether that happened.
+			blockMap->threatChanges = auxThreatChanges[type.owner];
+			if (prevMap != NULL && !prevMap->dangerMap.empty() && prevMap->dangerOwner == type.owner && prevMap->threatChanges == blockMap->threatChanges)
+			{
+				blockMap->dangerMap = prevMap->dangerMap;
+				blockMap->dangerHash = prevMap->dangerHash;
+			}
+			else
+			{
+				blockMap->dangerHash = fpathFillBits(blockMap->dangerMap, [&](int x, int y) {
+					return (auxTile(x, y, type.owner) & AUXBITS_THREAT) != 0;
+				});
+			}
+		}
+		syncDebug("blockingMap(%d,%d,%d,%d) = %08X %08X", gameTime, psJob->propulsion, psJob->owner, psJob->moveType, blockMap->hash, blockMap->dangerHash);
+
+		// Update the abstract graph, reusing the sectors which did not change since the last map of this type.
+		fpathUpdateSectors(*blockMap, prevMap, changedTiles);
+		if (last != fpathLastBlockingMaps.end())
+		{
+			*last = fpathBlockingMaps.back();
+		}
+		else
+		{
+			fpathLastBlockingMaps.push_back(fpathBlockingMaps.back());
 		}
-		syncDebug("blockingMap(%d,%d,%d,%d) = %08X %08X", gameTime, psJob->propulsion, psJob->owner, psJob->moveType, checksumMap, checksumDangerMap);
 
 		psJob->blockingMap = fpathBlockingMaps.back();
 	}
@@ -34,7 +34,16 @@ enum ASR_RETVAL
 	ASR_NEAREST,    ///< found a partial route to a nearby position
 };
 
-/** Use the A* algorithm to find a path
+/** Number of independent caches of pathfinding contexts.
+ *
+ *  Since cached contexts can affect the resulting paths, each cache must be used by only one thread at a time, and by
+ *  the same jobs in the same order on all clients. This is fixed, so that paths do not depend on the number of threads.
+ *
+ *  @ingroup pathfinding
+ */
+#define FPATH_CONTEXT_CACHES 8
+
+/** Use the A* algorithm to find a path, using the context cache psJob->contextCache.
  *
  *  @ingroup pathfinding
  */
@@ -95,6 +95,8 @@ struct SIMPLE_OBJECT
 
 #define BASEFLAG_TARGETED  0x01 ///< Whether object is targeted by a selectedPlayer droid sensor (quite the hack)
 #define BASEFLAG_DIRTY     0x02 ///< Whether certain recalculations are needed for object on frame update
+#define BASEFLAG_VISTILES  0x04 ///< Whether the tiles seen by the object need updating at the next processVisibility(), see visTilesUpdateLater()
+#define BASEFLAG_TARGETSEARCH 0x08 ///< Whether the object missed its turn to search for a target, see aiTargetSearchDue()
 
 #define MAX_WEAPONS 3
 
@@ -113,12 +115,14 @@ struct BASE_OBJECT : public SIMPLE_OBJECT
 	UDWORD              lastEmission;               ///< When did it last puff out smoke?
 	WEAPON_SUBCLASS     lastHitWeapon;              ///< The weapon that last hit it
 	UDWORD              timeLastHit;                ///< The time the structure was last attacked
+	UDWORD              timeTargetSearch;           ///< The time the object last searched for a target, see aiTargetSearchDue()
 	UDWORD              body;                       ///< Hit points with lame name
 	UDWORD              periodicalDamageStart;                  ///< When the object entered the fire
 	UDWORD              periodicalDamage;                 ///< How much damage has been done since the object entered the fire
 	uint16_t            flags;                      ///< Various flags
 	bool                jammedTiles;                ///< True if any tiles are being jammed.
 	TILEPOS             *watchedTiles;              ///< Variable size array of watched tiles, NULL for features
+	struct WavecastCache *wavecastCache;            ///< The tiles seen by the last wavecast, NULL if none done yet
 
 	UDWORD              timeAnimationStarted;       ///< Animation start time, zero for do not animate
 	UBYTE               animationEvent;             ///< If animation start time > 0, this points to which animation to run
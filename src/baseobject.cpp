@@ -29,6 +29,7 @@
 #include "feature.h"
 #include "intdisplay.h"
 #include "map.h"
+#include "visibility.h"
 
 
 static inline uint16_t interpolateAngle(uint16_t v1, uint16_t v2, uint32_t t1, uint32_t t2, uint32_t t)
@@ -100,12 +101,14 @@ BASE_OBJECT::BASE_OBJECT(OBJECT_TYPE type, uint32_t id, unsigned player)
 	, lastEmission(0)
 	, lastHitWeapon(WSC_NUM_WEAPON_SUBCLASSES)  // No such weapon.
 	, timeLastHit(UDWORD_MAX)
+	, timeTargetSearch(0)
 	, body(0)
 	, periodicalDamageStart(0)
 	, periodicalDamage(0)
 	, flags(0)
 	, jammedTiles(false)
 	, watchedTiles(NULL)
+	, wavecastCache(NULL)
 	, timeAnimationStarted(0)
 	, animationEvent(ANIM_EVENT_NONE)
 {
@@ -121,6 +124,7 @@ BASE_OBJECT::~BASE_OBJECT()
 {
 	visRemoveVisibility(this);
 	free(watchedTiles);
+	delete wavecastCache;
 
 #ifdef DEBUG
 	psNext = this;                                                       // Hopefully this will trigger an infinite loop       if someone uses the freed object.
@@ -29,6 +29,7 @@
 #include "lib/ivis_opengl/screen.h"
 #include "lib/netplay/netplay.h"
 #include "lib/ivis_opengl/pieclip.h"
+#include "lib/ivis_opengl/piemode.h"
 
 #include "clparse.h"
 #include "display3d.h"
@@ -81,6 +82,10 @@ typedef struct _poptContext
 static bool wz_autogame = false;
 static std::string wz_saveandquit;
 static std::string wz_test;
+/// Replay file to play back
+static std::string wz_replay;
+/// Trace file for the tick profiler
+static std::string wz_profile;
 
 static void poptPrintHelp(poptContext ctx, FILE *output, bool show_all)
 {
@@ -251,6 +256,9 @@ typedef enum
 	CLI_AUTOGAME,
 	CLI_SAVEANDQUIT,
 	CLI_SKIRMISH,
+	CLI_HEADLESS,
+	CLI_REPLAY,
+	CLI_PROFILE,
 } CLI_OPTIONS;
 
 static const struct poptOption *getOptionsTable(void)
@@ -287,6 +295,9 @@ static const struct poptOption *getOptionsTable(void)
 		{ "autogame",   '\0', POPT_ARG_NONE,   NULL, CLI_AUTOGAME,   N_("Run games automatically for testing"), NULL, true },
 		{ "saveandquit", '\0', POPT_ARG_STRING, NULL, CLI_SAVEANDQUIT, N_("Immediately save game and quit"), N_("save name"), true },
 		{ "skirmish",   '\0', POPT_ARG_STRING, NULL, CLI_SKIRMISH,   N_("Start skirmish game with given settings file"), N_("test"), true },
+		{ "headless",   '\0', POPT_ARG_NONE,   NULL, CLI_HEADLESS,   N_("Run the game simulation as fast as possible, without display or sound"), NULL, true },
+		{ "replay",     '\0', POPT_ARG_STRING, NULL, CLI_REPLAY,     N_("Play back a recorded multiplayer or skirmish game"), N_("replay file"), false },
+		{ "profile",    '\0', POPT_ARG_STRING, NULL, CLI_PROFILE,    N_("Time the parts of each game tick, and write a Chrome trace to the given file"), N_("trace file"), true },
 		// Terminating entry
 		{ NULL,         '\0', 0,               NULL, 0,              NULL,                                    NULL, true },
 	};
@@ -402,6 +413,11 @@ bool ParseCommandLineEarly(int argc, const char **argv)
 			printf("Warzone 2100 - %s\n", version_getFormattedVersionString());
 			return false;
 
+		case CLI_HEADLESS:
+			// Needed before Qt looks for a display.
+			pie_SetHeadless(true);
+			break;
+
 		default:
 			break;
 		};
@@ -645,6 +661,30 @@ bool ParseCommandLine(int argc, const char **argv)
 			}
 			wz_test = token;
 			break;
+
+		case CLI_HEADLESS:
+			// Already parsed in ParseCommandLineEarly(), but the config has overridden the sound setting since.
+			war_setSoundEnabled(false);
+			break;
+
+		case CLI_REPLAY:
+			token = poptGetOptArg(poptCon);
+			if (token == NULL)
+			{
+				qFatal("Missing replay file");
+			}
+			wz_replay = token;
+			SetGameMode(GS_NORMAL);
+			break;
+
+		case CLI_PROFILE:
+			token = poptGetOptArg(poptCon);
+			if (token == NULL)
+			{
+				qFatal("Missing trace file");
+			}
+			wz_profile = token;
+			break;
 		};
 	}
 
@@ -665,3 +705,13 @@ const std::string &wz_skirmish_test()
 {
 	return wz_test;
 }
+
+const std::string &replay_file()
+{
+	return wz_replay;
+}
+
+const std::string &profile_file()
+{
+	return wz_profile;
+}
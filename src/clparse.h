@@ -31,5 +31,7 @@ bool ParseCommandLineEarly(int argc, const char **argv);
 bool autogame_enabled();
 const std::string &saveandquit_enabled();
 const std::string &wz_skirmish_test();
+const std::string &replay_file();
+const std::string &profile_file();
 
 #endif // __INCLUDED_SRC_CLPARSE_H__
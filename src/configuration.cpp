@@ -150,6 +150,9 @@ bool loadConfig()
 	war_SetColouredCursor(ini.value("coloredCursor", true).toBool());
 	// this should be enabled on all systems by default
 	war_SetVsync(ini.value("vsync", true).toBool());
+	war_setPathThreads(ini.value("pathThreads", 0).toInt());
+	war_setWorkerThreads(ini.value("workerThreads", 0).toInt());
+	war_setReplayKeep(ini.value("replayKeep", 0).toInt());
 	// 640x480 is minimum that we will support, but default to something more sensible
 	int width = ini.value("width", war_GetWidth()).toInt();
 	int height = ini.value("height", war_GetHeight()).toInt();
@@ -219,6 +222,9 @@ bool saveConfig()
 	ini.setValue("vsync", war_GetVsync());
 	ini.setValue("textureSize", getTextureSize());
 	ini.setValue("antialiasing", war_getAntialiasing());
+	ini.setValue("pathThreads", war_getPathThreads());
+	ini.setValue("workerThreads", war_getWorkerThreads());
+	ini.setValue("replayKeep", war_getReplayKeep());
 	ini.setValue("UPnP", (SDWORD)NetPlay.isUPNP);
 	ini.setValue("rotateRadar", rotateRadar);
 	ini.setValue("PauseOnFocusLoss", war_GetPauseOnFocusLoss());
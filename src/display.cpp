@@ -1953,7 +1953,7 @@ void	dealWithLMB(void)
 			        mouseTileX, mouseTileY, world_coord(mouseTileX), world_coord(mouseTileY),
 			        (int)psTile->limitedContinent, (int)psTile->hoverContinent, psTile->level, (int)psTile->illumination,
 			        aux & AUXBITS_DANGER ? "danger" : "", aux & AUXBITS_THREAT ? "threat" : "",
-			        (int)psTile->watchers[selectedPlayer], (int)psTile->sensors[selectedPlayer], (int)psTile->jammers[selectedPlayer]);
+			        (int)tileVision(psTile)->watchers[selectedPlayer], (int)tileVision(psTile)->sensors[selectedPlayer], (int)tileVision(psTile)->jammers[selectedPlayer]);
 		}
 
 		return;
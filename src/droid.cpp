@@ -27,6 +27,7 @@
 #include "lib/framework/math_ext.h"
 #include "lib/framework/geometry.h"
 #include "lib/framework/strres.h"
+#include "lib/framework/wzpool.h"
 
 #include "lib/gamelib/gtime.h"
 #include "lib/ivis_opengl/piematrix.h"
@@ -346,6 +347,18 @@ DROID::DROID(uint32_t id, unsigned player)
 	lastFrustratedTime = 0;		// make sure we do not start the game frustrated
 }
 
+static WzPool droidPool("DROID", sizeof(DROID));
+
+void *DROID::operator new(size_t size)
+{
+	return droidPool.alloc(size);
+}
+
+void DROID::operator delete(void *ptr, size_t size)
+{
+	droidPool.free(ptr, size);
+}
+
 /* DROID::~DROID: release all resources associated with a droid -
  * should only be called by objmem - use vanishDroid preferably
  */
@@ -67,6 +67,7 @@ void raiseTile(int tile3dX, int tile3dY)
 		{
 			adjustTileHeight(mapTile(i, j), TILE_RAISE);
 			markTileDirty(i, j);
+			mapHeightChanged(i, j);
 		}
 	}
 }
@@ -86,6 +87,7 @@ void lowerTile(int tile3dX, int tile3dY)
 		{
 			adjustTileHeight(mapTile(i, j), TILE_LOWER);
 			markTileDirty(i, j);
+			mapHeightChanged(i, j);
 		}
 	}
 }
@@ -40,6 +40,7 @@
 #include "lib/framework/frameresource.h"
 #include "lib/framework/input.h"
 #include "lib/framework/math_ext.h"
+#include "lib/framework/wzpool.h"
 
 #include "lib/ivis_opengl/ivisdef.h"
 #include "lib/ivis_opengl/pietypes.h"
@@ -207,6 +208,18 @@ static void effectStructureUpdates();
 
 static UDWORD effectGetNumFrames(EFFECT *psEffect);
 
+static WzPool effectPool("EFFECT", sizeof(EFFECT));
+
+void *EFFECT::operator new(size_t size)
+{
+	return effectPool.alloc(size);
+}
+
+void EFFECT::operator delete(void *ptr, size_t size)
+{
+	effectPool.free(ptr, size);
+}
+
 void shutdownEffectsSystem()
 {
 	for (auto eff : activeList)
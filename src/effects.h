@@ -144,6 +144,9 @@ struct EFFECT
 	EFFECT() : player(MAX_PLAYERS), control(0), group(EFFECT_FREED), type(EXPLOSION_TYPE_SMALL), frameNumber(0), size(0),
 	           baseScale(0), specific(0), birthTime(0), lastFrame(0), frameDelay(0), lifeSpan(0), radius(0),
 	           imd(NULL), prev(NULL), next(NULL) {}
+
+	static void *operator new(size_t size);            ///< Allocates from a WzPool.
+	static void operator delete(void *ptr, size_t size);
 };
 
 /* Maximum number of effects in the world - need to investigate what this should be */
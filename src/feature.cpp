@@ -24,6 +24,7 @@
  */
 #include "lib/framework/frame.h"
 #include "lib/framework/wzconfig.h"
+#include "lib/framework/wzpool.h"
 
 #include "lib/gamelib/gtime.h"
 #include "lib/sound/audio.h"
@@ -294,6 +295,7 @@ FEATURE *buildFeature(FEATURE_STATS *psStats, UDWORD x, UDWORD y, bool FromSave)
 			if ((!psStats->tileDraw) && (FromSave == false))
 			{
 				psTile->height = height;
+				mapHeightChanged(b.map.x + width, b.map.y + breadth);
 			}
 		}
 	}
@@ -308,6 +310,18 @@ FEATURE::FEATURE(uint32_t id, FEATURE_STATS const *psStats)
 	, psStats(psStats)
 {}
 
+static WzPool featurePool("FEATURE", sizeof(FEATURE));
+
+void *FEATURE::operator new(size_t size)
+{
+	return featurePool.alloc(size);
+}
+
+void FEATURE::operator delete(void *ptr, size_t size)
+{
+	featurePool.free(ptr, size);
+}
+
 /* Release the resources associated with a feature */
 FEATURE::~FEATURE()
 {
@@ -67,6 +67,9 @@ struct FEATURE : public BASE_OBJECT
 	FEATURE(uint32_t id, FEATURE_STATS const *psStats);
 	~FEATURE();
 
+	static void *operator new(size_t size);            ///< Allocates from a WzPool.
+	static void operator delete(void *ptr, size_t size);
+
 	FEATURE_STATS const *psStats;
 };
 
@@ -32,11 +32,13 @@
 #include "lib/netplay/netplay.h"
 
 #include "lib/framework/wzapp.h"
+#include "lib/framework/wzprofile.h"
 
 #include "objects.h"
 #include "map.h"
 #include "multiplay.h"
 #include "astar.h"
+#include "warzoneconfig.h"
 
 #include "fpath.h"
 
@@ -56,11 +58,20 @@ struct PATHRESULT
 
 
 // threading stuff
-static WZ_THREAD        *fpathThread = NULL;
+using packagedPathJob = wz::packaged_task<PATHRESULT()>;
+
+/// Queued jobs for one context cache. Only one thread at a time may process jobs from the same cache.
+struct PathJobQueue
+{
+	std::list<packagedPathJob> jobs;
+	bool busy = false;              ///< A thread is processing a job from this queue.
+};
+
+static std::vector<WZ_THREAD *> fpathThreads;
 static WZ_MUTEX         *fpathMutex = NULL;
 static WZ_SEMAPHORE     *fpathSemaphore = NULL;
-using packagedPathJob = wz::packaged_task<PATHRESULT()>;
-static std::list<packagedPathJob>    pathJobs;
+static unsigned         fpathIdleThreads = 0;           ///< Number of threads waiting for fpathSemaphore, and not yet woken up.
+static PathJobQueue     pathJobs[FPATH_CONTEXT_CACHES];
 static std::unordered_map<uint32_t, wz::future<PATHRESULT>> pathResults;
 
 static bool             waitingForResult = false;
@@ -70,16 +81,36 @@ static WZ_SEMAPHORE     *waitingForResultSemaphore = NULL;
 static PATHRESULT fpathExecute(PATHJOB psJob);
 
 
-/** This runs in a separate thread */
+/** Finds a queue with jobs that no other thread is processing. Must hold fpathMutex. */
+static PathJobQueue *fpathFindJobQueue()
+{
+	static unsigned nextQueue = 0;  // Take turns, so that no queue has to wait for the others to be empty.
+
+	for (unsigned n = 0; n < FPATH_CONTEXT_CACHES; ++n)
+	{
+		PathJobQueue &queue = pathJobs[(nextQueue + n) % FPATH_CONTEXT_CACHES];
+		if (!queue.busy && !queue.jobs.empty())
+		{
+			nextQueue = (nextQueue + n + 1) % FPATH_CONTEXT_CACHES;
+			return &queue;
+		}
+	}
+	return NULL;
+}
+
+/** This runs in separate threads */
 static int fpathThreadFunc(void *)
 {
+	wzProfileThreadName("pathfinding");
 	wzMutexLock(fpathMutex);
 
 	while (!fpathQuit)
 	{
-		if (pathJobs.empty())
+		PathJobQueue *queue = fpathFindJobQueue();
+		if (queue == NULL)
 		{
 			ASSERT(!waitingForResult, "Waiting for a result (id %u) that doesn't exist.", waitingForResultId);
+			++fpathIdleThreads;
 			wzMutexUnlock(fpathMutex);
 			wzSemaphoreWait(fpathSemaphore);  // Go to sleep until needed.
 			wzMutexLock(fpathMutex);
@@ -87,13 +118,18 @@ static int fpathThreadFunc(void *)
 		}
 
 		// Copy the first job from the queue.
-		packagedPathJob job = std::move(pathJobs.front());
-		pathJobs.pop_front();
+		packagedPathJob job = std::move(queue->jobs.front());
+		queue->jobs.pop_front();
+		queue->busy = true;
 
 		wzMutexUnlock(fpathMutex);
-		job();
+		{
+			WzProfileScope profile("fpathJob");
+			job();
+		}
 		wzMutexLock(fpathMutex);
 
+		queue->busy = false;
 		waitingForResult = false;
 		objTrace(waitingForResultId, "These are the droids you are looking for.");
 		wzSemaphorePost(waitingForResultSemaphore);
@@ -109,13 +145,26 @@ bool fpathInitialise(void)
 	// The path system is up
 	fpathQuit = false;
 
-	if (!fpathThread)
+	if (fpathThreads.empty())
 	{
 		fpathMutex = wzMutexCreate();
 		fpathSemaphore = wzSemaphoreCreate(0);
 		waitingForResultSemaphore = wzSemaphoreCreate(0);
-		fpathThread = wzThreadCreate(fpathThreadFunc, NULL);
-		wzThreadStart(fpathThread);
+		fpathIdleThreads = 0;
+
+		int numThreads = war_getPathThreads();
+		if (numThreads <= 0)
+		{
+			numThreads = wzGetCPUCount() - 1;  // Leave a core for the main thread.
+		}
+		// More threads than context caches would never have anything to do.
+		numThreads = clip(numThreads, 1, FPATH_CONTEXT_CACHES);
+		debug(LOG_WZ, "Using %d path finding threads", numThreads);
+		for (int i = 0; i < numThreads; ++i)
+		{
+			fpathThreads.push_back(wzThreadCreate(fpathThreadFunc, NULL));
+			wzThreadStart(fpathThreads.back());
+		}
 	}
 
 	return true;
@@ -124,14 +173,20 @@ bool fpathInitialise(void)
 
 void fpathShutdown()
 {
-	// Signal the path finding thread to quit
+	// Signal the path finding threads to quit
 	fpathQuit = true;
-	wzSemaphorePost(fpathSemaphore);  // Wake up thread.
 
-	if (fpathThread)
+	if (!fpathThreads.empty())
 	{
-		wzThreadJoin(fpathThread);
-		fpathThread = NULL;
+		for (unsigned i = 0; i < fpathThreads.size(); ++i)
+		{
+			wzSemaphorePost(fpathSemaphore);  // Wake up threads.
+		}
+		for (unsigned i = 0; i < fpathThreads.size(); ++i)
+		{
+			wzThreadJoin(fpathThreads[i]);
+		}
+		fpathThreads.clear();
 		wzMutexDestroy(fpathMutex);
 		fpathMutex = NULL;
 		wzSemaphoreDestroy(fpathSemaphore);
@@ -312,6 +367,19 @@ void fpathRemoveDroidData(int id)
 	pathResults.erase(id);
 }
 
+/** Chooses the context cache for a job. Jobs to the same destination with the same blocking map share a cache, so they
+ *  can reuse each other's work, while other jobs are spread over the caches, so they can be processed in parallel.
+ */
+static unsigned fpathContextCache(PATHJOB const &job)
+{
+	uint32_t hash = map_coord(job.destX);
+	hash = hash * 257 + map_coord(job.destY);
+	hash = hash * 17 + job.owner;
+	hash = hash * 17 + job.propulsion;
+	hash = hash * 5 + job.moveType;
+	return hash % FPATH_CONTEXT_CACHES;
+}
+
 static FPATH_RETVAL fpathRoute(MOVE_CONTROL *psMove, unsigned id, int startX, int startY, int tX, int tY, PROPULSION_TYPE propulsionType,
                                DROID_TYPE droidType, FPATH_MOVETYPE moveType, int owner, bool acceptNearest, StructureBounds const &dstStructure)
 {
@@ -385,6 +453,7 @@ queuePathfinding:
 	job.owner = owner;
 	job.acceptNearest = acceptNearest;
 	job.deleted = false;
+	job.contextCache = fpathContextCache(job);
 	fpathSetBlockingMap(&job);
 
 	debug(LOG_NEVER, "starting new job for droid %d 0x%x", id, id);
@@ -397,16 +466,16 @@ queuePathfinding:
 
 	// Add to end of list
 	wzMutexLock(fpathMutex);
-	bool isFirstJob = pathJobs.empty();
-	pathJobs.push_back(std::move(task));
-	wzMutexUnlock(fpathMutex);
-
-	if (isFirstJob)
+	size_t earlierJobs = pathJobs[job.contextCache].jobs.size();
+	pathJobs[job.contextCache].jobs.push_back(std::move(task));
+	if (fpathIdleThreads > 0)
 	{
-		wzSemaphorePost(fpathSemaphore);  // Wake up processing thread.
+		--fpathIdleThreads;
+		wzSemaphorePost(fpathSemaphore);  // Wake up a processing thread.
 	}
+	wzMutexUnlock(fpathMutex);
 
-	objTrace(id, "Queued up a path-finding request to (%d, %d), at least %d items earlier in queue", tX, tY, isFirstJob);
+	objTrace(id, "Queued up a path-finding request to (%d, %d), %d items earlier in queue %u", tX, tY, (int)earlierJobs, job.contextCache);
 	syncDebug("fpathRoute(..., %d, %d, %d, %d, %d, %d, %d, %d, %d) = FPR_WAIT", id, startX, startY, tX, tY, propulsionType, droidType, moveType, owner);
 	return FPR_WAIT;	// wait while polling result queue
 }
@@ -511,7 +580,10 @@ static int fpathJobQueueLength(void)
 	int count = 0;
 
 	wzMutexLock(fpathMutex);
-	count = pathJobs.size();  // O(N) function call for std::list. .empty() is faster, but this function isn't used except in tests.
+	for (unsigned i = 0; i < FPATH_CONTEXT_CACHES; ++i)
+	{
+		count += pathJobs[i].jobs.size();  // O(N) function call for std::list. .empty() is faster, but this function isn't used except in tests.
+	}
 	wzMutexUnlock(fpathMutex);
 	return count;
 }
@@ -545,10 +617,10 @@ void fpathTest(int x, int y, int x2, int y2)
 	(void)fpathJobQueueLength;
 
 	/* Check initial state */
-	assert(fpathThread != NULL);
+	assert(!fpathThreads.empty());
 	assert(fpathMutex != NULL);
 	assert(fpathSemaphore != NULL);
-	assert(pathJobs.empty());
+	assert(fpathJobQueueLength() == 0);
 	assert(pathResults.empty());
 	fpathRemoveDroidData(0);	// should not crash
 
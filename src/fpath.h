@@ -57,6 +57,7 @@ struct PATHJOB
 	std::shared_ptr<PathBlockingMap> blockingMap;   ///< Map of blocking tiles.
 	bool		acceptNearest;
 	bool            deleted;        ///< Droid was deleted, so throw away result when complete. Must still process this PATHJOB, since processing order can affect resulting paths (but can't affect the path length).
+	unsigned        contextCache;   ///< Which cache of pathfinding contexts to use. Jobs using the same cache are processed one at a time, in the order they were queued.
 };
 
 enum FPATH_RETVAL
@@ -1810,6 +1810,8 @@ bool loadGame(const char *pGameToLoad, bool keepObjects, bool freeMem, bool User
 		}
 		apsOilList[0] = NULL;
 		initFactoryNumFlag();
+		// The lists may have been moved to the mission lists by saveMissionData, so don't keep counting their structures while loading.
+		setCurrentStructQuantity(false);
 	}
 
 	if (UserSaveGame)//always !keepObjects
@@ -2220,6 +2222,7 @@ bool loadGame(const char *pGameToLoad, bool keepObjects, bool freeMem, bool User
 	if (gameType != GTYPE_SCENARIO_EXPAND)
 	{
 		psMapTiles = NULL;
+		psTileVision = NULL;
 		//load in the map file
 		aFileName[fileExten] = '\0';
 		strcat(aFileName, "game.map");
@@ -2612,6 +2615,7 @@ error:
 	freeAllFeatures();
 	droidTemplateShutDown();
 	psMapTiles = NULL;
+	psTileVision = NULL;
 
 	/* Start the game clock */
 	gameTimeStart();
@@ -4876,12 +4880,11 @@ bool loadSaveStructure(char *pFileData, UDWORD filesize)
 		}
 		// The original code here didn't work and so the scriptwriters worked round it by using the module ID - so making it work now will screw up
 		// the scripts -so in ALL CASES overwrite the ID!
-		psStructure->id = psSaveStructure->id > 0 ? psSaveStructure->id : 0xFEDBCA98; // hack to remove struct id zero
+		setObjectId(psStructure, psSaveStructure->id > 0 ? psSaveStructure->id : 0xFEDBCA98); // hack to remove struct id zero
 		psStructure->periodicalDamage = psSaveStructure->periodicalDamage;
 		periodicalDamageTime = psSaveStructure->periodicalDamageStart;
 		psStructure->periodicalDamageStart = periodicalDamageTime;
-		psStructure->status = (STRUCT_STATES)psSaveStructure->status;
-		if (psStructure->status == SS_BUILT)
+		if (psSaveStructure->status == SS_BUILT)
 		{
 			buildingComplete(psStructure);
 		}
@@ -4998,7 +5001,7 @@ static bool loadSaveStructure2(const char *pFileName, STRUCTURE **ppList)
 		}
 		if (id > 0)
 		{
-			psStructure->id = id;	// force correct ID
+			setObjectId(psStructure, id);	// force correct ID
 		}
 
 		// common BASE_OBJECT info
@@ -5159,8 +5162,7 @@ static bool loadSaveStructure2(const char *pFileName, STRUCTURE **ppList)
 				psStructure->asWeaps[j].rot = ini.vector3i("rotation/" + QString::number(j));
 			}
 		}
-		psStructure->status = (STRUCT_STATES)ini.value("status", SS_BUILT).toInt();
-		if (psStructure->status == SS_BUILT)
+		if (ini.value("status", SS_BUILT).toInt() == SS_BUILT)
 		{
 			buildingComplete(psStructure);
 		}
@@ -5538,7 +5540,7 @@ bool loadSaveFeature(char *pFileData, UDWORD filesize)
 			scriptSetDerrickPos(pFeature->pos.x, pFeature->pos.y);
 		}
 		//restore values
-		pFeature->id = psSaveFeature->id;
+		setObjectId(pFeature, psSaveFeature->id);
 		pFeature->rot.direction = DEG(psSaveFeature->direction);
 		pFeature->periodicalDamage = psSaveFeature->periodicalDamage;
 		if (psHeader->version >= VERSION_14)
@@ -5607,11 +5609,11 @@ bool loadSaveFeature2(const char *pFileName)
 		int id = ini.value("id", -1).toInt();
 		if (id > 0)
 		{
-			pFeature->id = id;
+			setObjectId(pFeature, id);
 		}
 		else
 		{
-			pFeature->id = generateSynchronisedObjectId();
+			setObjectId(pFeature, generateSynchronisedObjectId());
 		}
 		pFeature->rot = ini.vector3i("rotation");
 
@@ -6065,6 +6067,7 @@ bool loadSaveResearch(const char *pFileName)
 			{
 				MakeResearchPossible(psPlRes);
 			}
+			researchCandidatesChanged(plr);
 			psPlRes->currentPoints = points;
 			//for any research that has been completed - perform so that upgrade values are set up
 			if (researched == RESEARCHED)
@@ -31,6 +31,7 @@
 #include "lib/framework/file.h"
 #include "lib/framework/physfs_ext.h"
 #include "lib/framework/wzapp.h"
+#include "lib/framework/wzparallel.h"
 #include "lib/ivis_opengl/piemode.h"
 #include "lib/ivis_opengl/piestate.h"
 #include "lib/ivis_opengl/screen.h"
@@ -38,6 +39,7 @@
 #include "lib/ivis_opengl/tex.h"
 #include "lib/ivis_opengl/imd.h"
 #include "lib/netplay/netplay.h"
+#include "lib/netplay/netreplay.h"
 #include "lib/script/script.h"
 #include "lib/sound/audio_id.h"
 #include "lib/sound/cdaudio.h"
@@ -719,11 +721,16 @@ bool systemInitialise(void)
 		return false;
 	}
 
+	wzParallelInit(war_getWorkerThreads());
+
 	// Initialize the iVis text rendering module
 	wzSceneBegin("Main menu loop");
-	iV_TextInit();
+	if (!pie_Headless())
+	{
+		iV_TextInit();
 
-	pie_InitRadar();
+		pie_InitRadar();
+	}
 
 	readAIs();
 
@@ -736,7 +743,10 @@ bool systemInitialise(void)
 //
 void systemShutdown(void)
 {
-	pie_ShutdownRadar();
+	if (!pie_Headless())
+	{
+		pie_ShutdownRadar();
+	}
 	clearLoadedMods();
 
 	shutdownEffectsSystem();
@@ -767,11 +777,15 @@ void systemShutdown(void)
 	levShutDown();
 	widgShutDown();
 	fpathShutdown();
+	wzParallelShutdown();
 	mapShutdown();
 	debug(LOG_MAIN, "shutting down everything else");
 	pal_ShutDown();		// currently unused stub
 	frameShutDown();	// close screen / SDL / resources / cursors / trig
-	screenShutDown();
+	if (!pie_Headless())
+	{
+		screenShutDown();
+	}
 	closeConfig();		// "registry" close
 	cleanSearchPath();	// clean PHYSFS search paths
 	debug_exit();		// cleanup debug routines
@@ -1016,7 +1030,10 @@ bool stageOneShutDown(void)
 	//free up the gateway stuff?
 	gwShutDown();
 
-	shutdownTerrain();
+	if (!pie_Headless())
+	{
+		shutdownTerrain();
+	}
 
 	if (!mapShutdown())
 	{
@@ -1116,7 +1133,7 @@ bool stageTwoInitialise(void)
 	{
 		NETinitQueue(NETgameQueue(i));
 
-		if (!myResponsibility(i))
+		if (!myResponsibility(i) || NETisReplay())
 		{
 			NETsetNoSendOverNetwork(NETgameQueue(i));
 		}
@@ -1191,14 +1208,18 @@ bool stageThreeInitialise(void)
 	// reset the clock to normal speed
 	gameTimeResetMod();
 
-	if (!init3DView())	// Initialise 3d view stuff. After resLoad cause it needs the game palette initialised.
+	// Nothing is drawn when headless, so the terrain, camera and lighting are left alone.
+	if (!pie_Headless())
 	{
-		return false;
-	}
+		if (!init3DView())	// Initialise 3d view stuff. After resLoad cause it needs the game palette initialised.
+		{
+			return false;
+		}
 
-	effectResetUpdates();
-	initLighting(0, 0, mapWidth, mapHeight);
-	pie_InitLighting();
+		effectResetUpdates();
+		initLighting(0, 0, mapWidth, mapHeight);
+		pie_InitLighting();
+	}
 
 	if (bMultiPlayer)
 	{
@@ -1345,7 +1366,10 @@ bool campaignReset(void)
 	debug(LOG_MAIN, "campaignReset");
 	gwShutDown();
 	mapShutdown();
-	shutdownTerrain();
+	if (!pie_Headless())
+	{
+		shutdownTerrain();
+	}
 	// when the terrain textures are reloaded we need to reset the radar
 	// otherwise it will end up as a terrain texture somehow
 	ShutdownRadar();
@@ -28,6 +28,7 @@
 #include "lib/framework/strres.h"
 #include "lib/framework/wzapp.h"
 #include "lib/framework/rational.h"
+#include "lib/framework/wzprofile.h"
 
 #include "lib/ivis_opengl/pieblitfunc.h"
 #include "lib/ivis_opengl/piestate.h" //ivis render code
@@ -41,6 +42,7 @@
 #include "lib/sound/cdaudio.h"
 #include "lib/sound/mixer.h"
 #include "lib/netplay/netplay.h"
+#include "lib/netplay/netreplay.h"
 
 #include "loop.h"
 #include "objects.h"
@@ -135,6 +137,46 @@ LOOP_MISSION_STATE		loopMissionState = LMS_NORMAL;
 // this is set by scrStartMission to say what type of new level is to be started
 LEVEL_TYPE nextMissionType = LDS_NONE;
 
+// Deal with the mission state, returns GAMECODE_CONTINUE unless the level needs to change.
+static GAMECODE missionStateUpdate()
+{
+	switch (loopMissionState)
+	{
+	case LMS_CLEAROBJECTS:
+		missionDestroyObjects();
+		setScriptPause(true);
+		loopMissionState = LMS_SETUPMISSION;
+		break;
+
+	case LMS_NORMAL:
+		// default
+		break;
+	case LMS_SETUPMISSION:
+		setScriptPause(false);
+		if (!setUpMission(nextMissionType))
+		{
+			return GAMECODE_QUITGAME;
+		}
+		break;
+	case LMS_SAVECONTINUE:
+		// just wait for this to be changed when the new mission starts
+		break;
+	case LMS_NEWLEVEL:
+		//nextMissionType = MISSION_NONE;
+		nextMissionType = LDS_NONE;
+		return GAMECODE_NEWLEVEL;
+		break;
+	case LMS_LOADGAME:
+		return GAMECODE_LOADGAME;
+		break;
+	default:
+		ASSERT(false, "unknown loopMissionState");
+		break;
+	}
+
+	return GAMECODE_CONTINUE;
+}
+
 static GAMECODE renderLoop()
 {
 	if (bMultiPlayer && !NetPlay.isHostAlive && NetPlay.bComms && !NetPlay.isHost)
@@ -354,38 +396,10 @@ static GAMECODE renderLoop()
 	}
 
 	// deal with the mission state
-	switch (loopMissionState)
+	GAMECODE missionCode = missionStateUpdate();
+	if (missionCode != GAMECODE_CONTINUE)
 	{
-	case LMS_CLEAROBJECTS:
-		missionDestroyObjects();
-		setScriptPause(true);
-		loopMissionState = LMS_SETUPMISSION;
-		break;
-
-	case LMS_NORMAL:
-		// default
-		break;
-	case LMS_SETUPMISSION:
-		setScriptPause(false);
-		if (!setUpMission(nextMissionType))
-		{
-			return GAMECODE_QUITGAME;
-		}
-		break;
-	case LMS_SAVECONTINUE:
-		// just wait for this to be changed when the new mission starts
-		break;
-	case LMS_NEWLEVEL:
-		//nextMissionType = MISSION_NONE;
-		nextMissionType = LDS_NONE;
-		return GAMECODE_NEWLEVEL;
-		break;
-	case LMS_LOADGAME:
-		return GAMECODE_LOADGAME;
-		break;
-	default:
-		ASSERT(false, "unknown loopMissionState");
-		break;
+		return missionCode;
 	}
 
 	int clearMode = 0;
@@ -544,6 +558,8 @@ static void countUpdate(bool synch)
 
 static void gameStateUpdate()
 {
+	WzProfileScope profile("gameStateUpdate");
+
 	syncDebug("map = \"%s\", pseudorandom 32-bit integer = 0x%08X, allocated = %d %d %d %d %d %d %d %d %d %d, position = %d %d %d %d %d %d %d %d %d %d", game.map, gameRandU32(),
 	          NetPlay.players[0].allocated, NetPlay.players[1].allocated, NetPlay.players[2].allocated, NetPlay.players[3].allocated, NetPlay.players[4].allocated, NetPlay.players[5].allocated, NetPlay.players[6].allocated, NetPlay.players[7].allocated, NetPlay.players[8].allocated, NetPlay.players[9].allocated,
 	          NetPlay.players[0].position, NetPlay.players[1].position, NetPlay.players[2].position, NetPlay.players[3].position, NetPlay.players[4].position, NetPlay.players[5].position, NetPlay.players[6].position, NetPlay.players[7].position, NetPlay.players[8].position, NetPlay.players[9].position
@@ -566,6 +582,8 @@ static void gameStateUpdate()
 
 	if (!paused && !scriptPaused())
 	{
+		WzProfileScope profileScripts("scripts");
+
 		/* Update the event system */
 		if (!bInTutorial)
 		{
@@ -585,19 +603,34 @@ static void gameStateUpdate()
 	visUpdateLevel();
 
 	// Put all droids/structures/features into the grid.
-	gridReset();
+	{
+		WzProfileScope profileGrid("gridReset");
+		gridReset();
+	}
 
 	// Check which objects are visible.
-	processVisibility();
+	{
+		WzProfileScope profileVisibility("processVisibility");
+		processVisibility();
+	}
 
 	// Update the map.
-	mapUpdate();
+	{
+		WzProfileScope profileMap("mapUpdate");
+		mapUpdate();
+	}
 
 	//update the findpath system
-	fpathUpdate();
+	{
+		WzProfileScope profileFpath("fpathUpdate");
+		fpathUpdate();
+	}
 
 	// update the cluster system
-	clusterUpdate();
+	{
+		WzProfileScope profileCluster("clusterUpdate");
+		clusterUpdate();
+	}
 
 	// update the command droids
 	cmdDroidUpdate();
@@ -609,41 +642,50 @@ static void gameStateUpdate()
 		//update the current power available for a player
 		updatePlayerPower(i);
 
-		DROID *psNext;
-		for (DROID *psCurr = apsDroidLists[i]; psCurr != NULL; psCurr = psNext)
 		{
-			// Copy the next pointer - not 100% sure if the droid could get destroyed but this covers us anyway
-			psNext = psCurr->psNext;
-			droidUpdate(psCurr);
-		}
+			WzProfileScope profileDroids("droidUpdate", i);
+			DROID *psNext;
+			for (DROID *psCurr = apsDroidLists[i]; psCurr != NULL; psCurr = psNext)
+			{
+				// Copy the next pointer - not 100% sure if the droid could get destroyed but this covers us anyway
+				psNext = psCurr->psNext;
+				droidUpdate(psCurr);
+			}
 
-		for (DROID *psCurr = mission.apsDroidLists[i]; psCurr != NULL; psCurr = psNext)
-		{
-			/* Copy the next pointer - not 100% sure if the droid could
-			get destroyed but this covers us anyway */
-			psNext = psCurr->psNext;
-			missionDroidUpdate(psCurr);
+			for (DROID *psCurr = mission.apsDroidLists[i]; psCurr != NULL; psCurr = psNext)
+			{
+				/* Copy the next pointer - not 100% sure if the droid could
+				get destroyed but this covers us anyway */
+				psNext = psCurr->psNext;
+				missionDroidUpdate(psCurr);
+			}
 		}
 
 		// FIXME: These for-loops are code duplicationo
-		STRUCTURE *psNBuilding;
-		for (STRUCTURE *psCBuilding = apsStructLists[i]; psCBuilding != NULL; psCBuilding = psNBuilding)
-		{
-			/* Copy the next pointer - not 100% sure if the structure could get destroyed but this covers us anyway */
-			psNBuilding = psCBuilding->psNext;
-			structureUpdate(psCBuilding, false);
-		}
-		for (STRUCTURE *psCBuilding = mission.apsStructLists[i]; psCBuilding != NULL; psCBuilding = psNBuilding)
 		{
-			/* Copy the next pointer - not 100% sure if the structure could get destroyed but this covers us anyway. It shouldn't do since its not even on the map!*/
-			psNBuilding = psCBuilding->psNext;
-			structureUpdate(psCBuilding, true); // update for mission
+			WzProfileScope profileStructures("structureUpdate", i);
+			STRUCTURE *psNBuilding;
+			for (STRUCTURE *psCBuilding = apsStructLists[i]; psCBuilding != NULL; psCBuilding = psNBuilding)
+			{
+				/* Copy the next pointer - not 100% sure if the structure could get destroyed but this covers us anyway */
+				psNBuilding = psCBuilding->psNext;
+				structureUpdate(psCBuilding, false);
+			}
+			for (STRUCTURE *psCBuilding = mission.apsStructLists[i]; psCBuilding != NULL; psCBuilding = psNBuilding)
+			{
+				/* Copy the next pointer - not 100% sure if the structure could get destroyed but this covers us anyway. It shouldn't do since its not even on the map!*/
+				psNBuilding = psCBuilding->psNext;
+				structureUpdate(psCBuilding, true); // update for mission
+			}
 		}
 	}
 
 	missionTimerUpdate();
 
-	proj_UpdateAll();
+	{
+		WzProfileScope profileProjectiles("proj_UpdateAll");
+		proj_UpdateAll();
+	}
 
 	FEATURE *psNFeat;
 	for (FEATURE *psCFeat = apsFeatureLists[0]; psCFeat; psCFeat = psNFeat)
@@ -652,7 +694,10 @@ static void gameStateUpdate()
 		featureUpdate(psCFeat);
 	}
 
-	objmemUpdate();
+	{
+		WzProfileScope profileObjmem("objmemUpdate");
+		objmemUpdate();
+	}
 
 	// Clean up dead droid pointers in UI.
 	hciUpdate();
@@ -664,6 +709,34 @@ static void gameStateUpdate()
 	countUpdate(true);
 }
 
+/* The game loop without display, does exactly one game state update per call, as fast as possible */
+static GAMECODE headlessGameLoop()
+{
+	recvMessage();
+	if (NETisReplayFinished())
+	{
+		return GAMECODE_QUITGAME;  // Waiting for messages that will never come.
+	}
+
+	gameTimeUpdate(true);
+	if (deltaGameTime != 0)
+	{
+		ASSERT(!paused && !gameUpdatePaused(), "Nonsensical pause values.");
+
+		syncDebug("Begin game state update, gameTime = %d", gameTime);
+		gameStateUpdate();
+		syncDebug("End game state update, gameTime = %d", gameTime);
+	}
+
+	if (bMultiPlayer)
+	{
+		multiPlayerLoop();
+	}
+	NETflush();
+
+	return missionStateUpdate();
+}
+
 /* The main game loop */
 GAMECODE gameLoop(void)
 {
@@ -676,6 +749,11 @@ GAMECODE gameLoop(void)
 
 	countUpdate(false); // kick off with correct counts
 
+	if (pie_Headless())
+	{
+		return headlessGameLoop();
+	}
+
 	while (true)
 	{
 		// Receive NET_BLAH messages.
@@ -36,6 +36,7 @@
 
 #include "lib/framework/input.h"
 #include "lib/framework/physfs_ext.h"
+#include "lib/framework/wzprofile.h"
 #include "lib/exceptionhandler/exceptionhandler.h"
 #include "lib/exceptionhandler/dumpinfo.h"
 
@@ -65,8 +66,10 @@
 #include "loop.h"
 #include "mission.h"
 #include "modding.h"
+#include "multiint.h"
 #include "multiplay.h"
 #include "qtscript.h"
+#include "replay.h"
 #include "research.h"
 #include "scripttabs.h"
 #include "seqdisp.h"
@@ -76,6 +79,7 @@
 #include "version.h"
 #include "map.h"
 #include "keybind.h"
+#include <locale.h>
 #include <time.h>
 
 #if defined(WZ_OS_MAC)
@@ -568,6 +572,7 @@ static void startGameLoop(void)
 		debug(LOG_FATAL, "Shutting down after failure");
 		exit(EXIT_FAILURE);
 	}
+	replayGameStart();
 
 	screen_StopBackDrop();
 
@@ -599,6 +604,8 @@ static void startGameLoop(void)
  */
 static void stopGameLoop(void)
 {
+	replayGameStop();
+
 	if (gameLoopStatus != GAMECODE_NEWLEVEL)
 	{
 		clearBlueprints();
@@ -644,6 +651,10 @@ static bool initSaveGameLoad(void)
 		// Doesn't seem to be a way to tell where we are in game loop to determine if/when we should do the two calls.
 		gameLoopStatus = GAMECODE_FASTEXIT;	// clear out all old data
 		stopGameLoop();
+		if (pie_Headless())
+		{
+			exit(EXIT_FAILURE);  // No menu to go back to.
+		}
 		startTitleLoop(); // Restart into titleloop
 		SetGameMode(GS_TITLE_SCREEN);
 		return false;
@@ -680,6 +691,11 @@ static void runGameLoop(void)
 	case GAMECODE_QUITGAME:
 		debug(LOG_MAIN, "GAMECODE_QUITGAME");
 		stopGameLoop();
+		if (pie_Headless())
+		{
+			SetGameMode(GS_TITLE_SCREEN);  // No menu to go back to, this ends headlessMainLoop().
+			break;
+		}
 		startTitleLoop(); // Restart into titleloop
 		break;
 	case GAMECODE_LOADGAME:
@@ -793,6 +809,18 @@ void mainLoop(void)
 	RAND_add(buf, sizeof(buf), 1);
 }
 
+/*!
+ * The mainloop when running headless.
+ * There is no window to fetch events from, so just run the game until it is over.
+ */
+static void headlessMainLoop()
+{
+	while (GetGameMode() == GS_NORMAL)
+	{
+		mainLoop();
+	}
+}
+
 bool getUTF8CmdLine(int *const utfargc WZ_DECL_UNUSED, const char *** const utfargv WZ_DECL_UNUSED) // explicitely pass by reference
 {
 #ifdef WZ_OS_WIN
@@ -846,7 +874,6 @@ int realmain(int argc, char *argv[])
 {
 	int utfargc = argc;
 	const char **utfargv = (const char **)argv;
-	wzMain(argc, argv);		// init Qt integration first
 
 #if !defined(OPENSSL_API_COMPAT) || OPENSSL_API_COMPAT < 0x10100000L
 #pragma GCC diagnostic push
@@ -897,6 +924,13 @@ int realmain(int argc, char *argv[])
 		return EXIT_FAILURE;
 	}
 
+	if (pie_Headless())
+	{
+		qputenv("QT_QPA_PLATFORM", "offscreen");  // Don't let Qt look for a display.
+	}
+	wzMain(argc, argv);		// init Qt integration, before anything else uses Qt
+	setlocale(LC_NUMERIC, "C");	// QApplication set the whole locale from the environment, undoing initI18n()
+
 	/* Initialize the write/config directory for PhysicsFS.
 	 * This needs to be done __after__ the early commandline parsing,
 	 * because the user might tell us to use an alternative configuration
@@ -912,6 +946,7 @@ int realmain(int argc, char *argv[])
 	make_dir(MultiCustomMapsPath, "maps", NULL); // MUST have this to prevent crashes when getting map
 	PHYSFS_mkdir("music");
 	PHYSFS_mkdir("logs");		// a place to hold our netplay, mingw crash reports & WZ logs
+	PHYSFS_mkdir("replay");		// recorded multiplayer and skirmish games
 	PHYSFS_mkdir("userdata");	// a place to store per-mod data user generated data
 	memset(rulesettag, 0, sizeof(rulesettag)); // tag to add to userdata to find user generated stuff
 	make_dir(MultiPlayersPath, "multiplay", NULL);
@@ -966,6 +1001,22 @@ int realmain(int argc, char *argv[])
 	// Save new (commandline) settings
 	saveConfig();
 
+	if (pie_Headless())
+	{
+		bool skirmishTest = !wz_skirmish_test().empty() && autogame_enabled();
+		if (GetGameMode() != GS_NORMAL && GetGameMode() != GS_SAVEGAMELOAD && !skirmishTest)
+		{
+			debug(LOG_FATAL, "--headless needs a game to run, use --game, --loadskirmish, --loadcampaign, --replay or --skirmish with --autogame");
+			return EXIT_FAILURE;
+		}
+		gameTimeSetUnlimited(true);
+	}
+
+	if (!profile_file().empty() && !wzProfileStart(profile_file().c_str()))
+	{
+		return EXIT_FAILURE;
+	}
+
 	// Find out where to find the data
 	scanDataDirs();
 
@@ -1022,7 +1073,7 @@ int realmain(int argc, char *argv[])
 		}
 	}
 
-	if (!wzMainScreenSetup(war_getAntialiasing(), war_getFullscreen(), war_GetVsync()))
+	if (!pie_Headless() && !wzMainScreenSetup(war_getAntialiasing(), war_getFullscreen(), war_GetVsync()))
 	{
 		return EXIT_FAILURE;
 	}
@@ -1037,7 +1088,7 @@ int realmain(int argc, char *argv[])
 	int h = pie_GetVideoBufferHeight();
 
 	char buf[256];
-	ssprintf(buf, "Video Mode %d x %d (%s)", w, h, war_getFullscreen() ? "fullscreen" : "window");
+	ssprintf(buf, "Video Mode %d x %d (%s)", w, h, pie_Headless() ? "headless" : war_getFullscreen() ? "fullscreen" : "window");
 	addDumpInfo(buf);
 
 	debug(LOG_MAIN, "Final initialization");
@@ -1045,25 +1096,31 @@ int realmain(int argc, char *argv[])
 	{
 		return EXIT_FAILURE;
 	}
-	if (!screenInitialise())
+	if (!pie_Headless())
 	{
-		return EXIT_FAILURE;
-	}
-	if (!pie_LoadShaders())
-	{
-		return EXIT_FAILURE;
-	}
-	war_SetWidth(pie_GetVideoBufferWidth());
-	war_SetHeight(pie_GetVideoBufferHeight());
+		if (!screenInitialise())
+		{
+			return EXIT_FAILURE;
+		}
+		if (!pie_LoadShaders())
+		{
+			return EXIT_FAILURE;
+		}
+		war_SetWidth(pie_GetVideoBufferWidth());
+		war_SetHeight(pie_GetVideoBufferHeight());
 
-	pie_SetFogStatus(false);
-	pie_ScreenFlip(CLEAR_BLACK);
+		pie_SetFogStatus(false);
+		pie_ScreenFlip(CLEAR_BLACK);
+	}
 
 	pal_Init();
 
-	pie_LoadBackDrop(SCREEN_RANDOMBDROP);
-	pie_SetFogStatus(false);
-	pie_ScreenFlip(CLEAR_BLACK);
+	if (!pie_Headless())
+	{
+		pie_LoadBackDrop(SCREEN_RANDOMBDROP);
+		pie_SetFogStatus(false);
+		pie_ScreenFlip(CLEAR_BLACK);
+	}
 
 	if (!systemInitialise())
 	{
@@ -1084,11 +1141,27 @@ int realmain(int argc, char *argv[])
 	{
 	case GS_TITLE_SCREEN:
 		startTitleLoop();
+		if (pie_Headless())
+		{
+			// There is no frontend to set up the skirmish in, so host and start it straight away.
+			if (!startHeadlessSkirmish())
+			{
+				debug(LOG_FATAL, "Could not start the %s skirmish", wz_skirmish_test().c_str());
+				return EXIT_FAILURE;
+			}
+			stopTitleLoop();
+			startGameLoop();
+		}
 		break;
 	case GS_SAVEGAMELOAD:
 		initSaveGameLoad();
 		break;
 	case GS_NORMAL:
+		if (!replay_file().empty() && !replayLoad(replay_file().c_str()))
+		{
+			debug(LOG_FATAL, "Could not play back %s", replay_file().c_str());
+			return EXIT_FAILURE;
+		}
 		startGameLoop();
 		break;
 	default:
@@ -1100,9 +1173,17 @@ int realmain(int argc, char *argv[])
 	debug_MEMSTATS();
 #endif
 	debug(LOG_MAIN, "Entering main loop");
-	wzMainEventLoop();
+	if (pie_Headless())
+	{
+		headlessMainLoop();
+	}
+	else
+	{
+		wzMainEventLoop();
+	}
 	saveConfig();
 	systemShutdown();
+	wzProfileShutdown();
 #ifdef WZ_OS_WIN	// clean up the memory allocated for the command line conversion
 	for (int i = 0; i < argc; i++)
 	{
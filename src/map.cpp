@@ -29,6 +29,8 @@
 #include "lib/framework/endian_hack.h"
 #include "lib/framework/file.h"
 #include "lib/framework/physfs_ext.h"
+#include "lib/framework/wzparallel.h"
+#include "lib/framework/wzprofile.h"
 #include "lib/ivis_opengl/tex.h"
 #include "lib/netplay/netplay.h"  // For syncDebug
 
@@ -53,18 +55,58 @@
 
 #define GAME_TICKS_FOR_DANGER (GAME_TICKS_PER_SEC * 2)
 
-static WZ_THREAD *dangerThread = NULL;
-static WZ_SEMAPHORE *dangerSemaphore = NULL;
-static WZ_SEMAPHORE *dangerDoneSemaphore = NULL;
 struct floodtile
 {
 	uint8_t x;
 	uint8_t y;
 };
-static struct floodtile *floodbucket = NULL;
-static int bucketcounter;
+
+/// A player's threat and danger bits, worked out by the danger threads in a copy of the player's aux map.
+struct DangerMap
+{
+	DangerMap() : auxChanges(0), auxGeneration(0), threatChanged(false), auxCopied(false), updated(false) {}
+
+	std::vector<uint8_t> aux;        ///< Copy of the player's aux map, in which the threat and danger bits are worked out.
+	std::vector<uint32_t> threats;   ///< Tiles the player's enemies can shoot at, as (x + y * mapWidth) | (AUXBITS_THREAT and/or AUXBITS_AATHREAT) << 24.
+	std::vector<uint32_t> collected; ///< Threats being collected by the danger thread, reused to avoid reallocating.
+	size_t auxChanges;               ///< auxChangedTilesStart + auxChangedTiles.size() when aux was copied.
+	uint32_t auxGeneration;          ///< auxMapGeneration when aux was copied.
+	bool threatChanged;              ///< Whether threats changed since the threat bits of the player's aux map were last updated.
+	bool auxCopied;                  ///< Whether aux was copied since the danger map was last worked out.
+	bool updated;                    ///< Whether the danger map was worked out since aux was last copied back.
+};
+
+/// An object that can shoot, as copied for the danger threads.
+struct ThreatSource
+{
+	uint32_t seenBy;     ///< Bit i is set if player i is an enemy of the object's owner, and can see the object.
+	uint32_t bits;       ///< (AUXBITS_THREAT and/or AUXBITS_AATHREAT) << 24.
+	unsigned firstTile;  ///< Index of the object's first watched tile in threatSourceTiles.
+	unsigned numTiles;
+};
+
+static DangerMap dangerMaps[MAX_PLAYERS];
+static std::vector<ThreatSource> threatSources;               ///< Objects that can shoot, for the danger threads to collect each player's threats from.
+static std::vector<uint32_t> threatSourceTiles;               ///< Tiles the threatSources can shoot at, as x + y * mapWidth.
+static std::vector<int> dangerJobs;                           ///< Players whose danger maps the danger threads are working out, in order.
+static std::vector<std::vector<floodtile> > dangerBuckets;    ///< Open lists of dangerFloodFill, one for each thread.
+static std::vector<WZ_THREAD *> dangerThreads;
+static WZ_MUTEX *dangerMutex = NULL;                          ///< Protects dangerNext.
+static WZ_SEMAPHORE *dangerSemaphore = NULL;
+static WZ_SEMAPHORE *dangerDoneSemaphore = NULL;
+static unsigned dangerNext = 0;                               ///< Next item of dangerJobs to be worked out.
+static unsigned dangerRunning = 0;                            ///< Number of danger threads not yet done with dangerJobs.
+static bool dangerQuit = false;
 static UDWORD lastDangerUpdate = 0;
-static int lastDangerPlayer = -1;
+
+/// Waits for the danger threads to finish dangerJobs.
+static void dangerWait()
+{
+	for (; dangerRunning > 0; --dangerRunning)
+	{
+		wzSemaphoreWait(dangerDoneSemaphore);
+	}
+}
 
 //scroll min and max values
 SDWORD		scrollMinX, scrollMaxX, scrollMinY, scrollMaxY;
@@ -105,8 +147,17 @@ struct GATEWAY_SAVE
 /* The size and contents of the map */
 SDWORD	mapWidth = 0, mapHeight = 0;
 MAPTILE	*psMapTiles = NULL;
+TILE_VISION *psTileVision = NULL;
 uint8_t *psBlockMap[AUX_MAX];
 uint8_t *psAuxMap[MAX_PLAYERS + AUX_MAX];        // yes, we waste one element... eyes wide open... makes API nicer
+std::vector<uint32_t> auxChangedTiles;
+size_t auxChangedTilesStart = 0;
+uint32_t auxMapGeneration = 0;
+uint32_t auxThreatChanges[MAX_PLAYERS];
+uint32_t mapHeightChanges = 0;
+
+#define HEIGHT_CHANGE_BLOCK_SHIFT 3  // Height changes are recorded in blocks of 8×8 tiles.
+static uint32_t heightChangeBlocks[MAP_MAXHEIGHT >> HEIGHT_CHANGE_BLOCK_SHIFT][MAP_MAXWIDTH >> HEIGHT_CHANGE_BLOCK_SHIFT];  ///< mapHeightChanges after the last change to each block.
 
 #define WATER_MIN_DEPTH 500
 #define WATER_MAX_DEPTH (WATER_MIN_DEPTH + 400)
@@ -786,6 +837,8 @@ bool mapLoad(char *filename, bool preview)
 	/* Allocate the memory for the map */
 	psMapTiles = (MAPTILE *)calloc(width * height, sizeof(MAPTILE));
 	ASSERT(psMapTiles != NULL, "Out of memory");
+	psTileVision = (TILE_VISION *)calloc(width * height, sizeof(TILE_VISION));
+	ASSERT(psTileVision != NULL, "Out of memory");
 
 	mapWidth = width;
 	mapHeight = height;
@@ -820,9 +873,6 @@ bool mapLoad(char *filename, bool preview)
 		psMapTiles[i].height = height * ELEVATION_SCALE;
 
 		// Visibility stuff
-		memset(psMapTiles[i].watchers, 0, sizeof(psMapTiles[i].watchers));
-		memset(psMapTiles[i].sensors, 0, sizeof(psMapTiles[i].sensors));
-		memset(psMapTiles[i].jammers, 0, sizeof(psMapTiles[i].jammers));
 		psMapTiles[i].sensorBits = 0;
 		psMapTiles[i].jammerBits = 0;
 		psMapTiles[i].tileExploredBits = 0;
@@ -914,6 +964,8 @@ bool mapLoad(char *filename, bool preview)
 		}
 	}
 
+	auxMapReplaced();
+
 	/* Set continents. This should ideally be done in advance by the map editor. */
 	mapFloodFillContinents();
 ok:
@@ -1018,20 +1070,37 @@ bool mapShutdown(void)
 {
 	int x;
 
-	if (dangerThread)
+	if (!dangerThreads.empty())
 	{
-		wzSemaphoreWait(dangerDoneSemaphore);
-		lastDangerPlayer = -1;
-		wzSemaphorePost(dangerSemaphore);
-		wzThreadJoin(dangerThread);
+		dangerWait();
+		dangerQuit = true;
+		for (unsigned i = 0; i < dangerThreads.size(); ++i)
+		{
+			wzSemaphorePost(dangerSemaphore);  // Wake up threads.
+		}
+		for (unsigned i = 0; i < dangerThreads.size(); ++i)
+		{
+			wzThreadJoin(dangerThreads[i]);
+		}
+		dangerThreads.clear();
+		wzMutexDestroy(dangerMutex);
 		wzSemaphoreDestroy(dangerSemaphore);
 		wzSemaphoreDestroy(dangerDoneSemaphore);
-		dangerThread = NULL;
+		dangerMutex = NULL;
 		dangerSemaphore = NULL;
 		dangerDoneSemaphore = NULL;
 	}
+	dangerJobs.clear();
+	dangerBuckets.clear();
+	threatSources.clear();
+	threatSourceTiles.clear();
+	for (x = 0; x < MAX_PLAYERS; x++)
+	{
+		dangerMaps[x] = DangerMap();
+	}
 
 	free(psMapTiles);
+	free(psTileVision);
 	delete[] mapDecals;
 	free(psGroundTypes);
 	free(map);
@@ -1041,7 +1110,6 @@ bool mapShutdown(void)
 	free(psBlockMap[AUX_ASTARMAP]);
 	psBlockMap[AUX_ASTARMAP] = NULL;
 	free(psBlockMap[AUX_DANGERMAP]);
-	free(floodbucket);
 	psBlockMap[AUX_DANGERMAP] = NULL;
 	for (x = 0; x < MAX_PLAYERS + AUX_MAX; x++)
 	{
@@ -1050,16 +1118,62 @@ bool mapShutdown(void)
 	}
 
 	map = NULL;
-	floodbucket = NULL;
 	psGroundTypes = NULL;
 	mapDecals = NULL;
 	psMapTiles = NULL;
+	psTileVision = NULL;
 	mapWidth = mapHeight = 0;
 	numTile_names = 0;
 	Tile_names = NULL;
+	auxMapReplaced();
 	return true;
 }
 
+void auxMapReplaced()
+{
+	++auxMapGeneration;
+	auxChangedTilesStart += auxChangedTiles.size();
+	auxChangedTiles.clear();
+}
+
+void auxForgetChanges(size_t upTo)
+{
+	size_t forget = std::min(upTo - std::min(upTo, auxChangedTilesStart), auxChangedTiles.size());
+	// If nothing is reading the changes, don't let them pile up, forgetting them is cheaper than keeping them when there are this many.
+	forget = std::max<size_t>(forget, auxChangedTiles.size() - std::min<size_t>(auxChangedTiles.size(), mapWidth * mapHeight));
+	auxChangedTiles.erase(auxChangedTiles.begin(), auxChangedTiles.begin() + forget);
+	auxChangedTilesStart += forget;
+}
+
+void mapHeightChanged(int x, int y)
+{
+	ASSERT_OR_RETURN(, x >= 0 && x < MAP_MAXWIDTH && y >= 0 && y < MAP_MAXHEIGHT, "Tile (%d, %d) off map", x, y);
+	heightChangeBlocks[y >> HEIGHT_CHANGE_BLOCK_SHIFT][x >> HEIGHT_CHANGE_BLOCK_SHIFT] = ++mapHeightChanges;
+}
+
+bool mapHeightChangedSince(uint32_t changes, int x1, int y1, int x2, int y2)
+{
+	if (changes == mapHeightChanges)
+	{
+		return false;  // Nothing changed anywhere.
+	}
+	x1 = MAX(x1, 0) >> HEIGHT_CHANGE_BLOCK_SHIFT;
+	y1 = MAX(y1, 0) >> HEIGHT_CHANGE_BLOCK_SHIFT;
+	x2 = MIN(x2, MAP_MAXWIDTH - 1) >> HEIGHT_CHANGE_BLOCK_SHIFT;
+	y2 = MIN(y2, MAP_MAXHEIGHT - 1) >> HEIGHT_CHANGE_BLOCK_SHIFT;
+	for (int y = y1; y <= y2; ++y)
+	{
+		for (int x = x1; x <= x2; ++x)
+		{
+			if (heightChangeBlocks[y][x] > changes)
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
 /**
  * Intersect a tile with a line and report the points of intersection
  * line is gives as point plus 2d directional vector
@@ -1776,24 +1890,200 @@ bool fireOnLocation(unsigned int x, unsigned int y)
 	return psTile != NULL && TileIsBurning(psTile);
 }
 
+/// Copies the tiles the object can shoot at to threatSources, along with which of its enemies can see it.
+static inline void threatSourceAdd(BASE_OBJECT *psObj, UBYTE mode, uint32_t enemies)
+{
+	uint32_t bits = ((mode & SHOOT_ON_GROUND) ? AUXBITS_THREAT : 0) | ((mode & SHOOT_IN_AIR) ? AUXBITS_AATHREAT : 0);
+	uint32_t seenBy = 0;
+
+	for (int i = 0; i < MAX_PLAYERS; i++)
+	{
+		if (psObj->visible[i] || psObj->born == 2)
+		{
+			seenBy |= 1 << i;
+		}
+	}
+	seenBy &= enemies;
+	if (bits != 0 && seenBy != 0 && psObj->numWatchedTiles > 0)
+	{
+		ThreatSource source;
+		source.seenBy = seenBy;
+		source.bits = bits << 24;
+		source.firstTile = threatSourceTiles.size();
+		source.numTiles = psObj->numWatchedTiles;
+		threatSources.push_back(source);
+		for (int i = 0; i < psObj->numWatchedTiles; i++)
+		{
+			const TILEPOS pos = psObj->watchedTiles[i];
+			threatSourceTiles.push_back(pos.x + pos.y * mapWidth);
+		}
+	}
+}
+
+/// Copies every object that can shoot to threatSources, in one pass for all players, so that the danger threads can each collect their own player's threats. Must be called from the main thread.
+static void threatSourcesStore()
+{
+	int weapon;
+
+	threatSources.clear();
+	threatSourceTiles.clear();
+	for (int i = 0; i < MAX_PLAYERS; i++)
+	{
+		uint32_t enemies = 0;  // Players who are threatened by player i's objects.
+		for (int player = 0; player < MAX_PLAYERS; player++)
+		{
+			if (!aiCheckAlliances(player, i))
+			{
+				enemies |= 1 << player;
+			}
+		}
+		if (enemies == 0)
+		{
+			continue;
+		}
+
+		for (DROID *psDroid = apsDroidLists[i]; psDroid; psDroid = psDroid->psNext)
+		{
+			UBYTE mode = 0;
+
+			if (psDroid->droidType == DROID_CONSTRUCT || psDroid->droidType == DROID_CYBORG_CONSTRUCT
+			    || psDroid->droidType == DROID_REPAIR || psDroid->droidType == DROID_CYBORG_REPAIR)
+			{
+				continue;	// hack that really should not be needed, but is -- trucks can SHOOT_ON_GROUND...!
+			}
+			for (weapon = 0; weapon < psDroid->numWeaps; weapon++)
+			{
+				mode |= asWeaponStats[psDroid->asWeaps[weapon].nStat].surfaceToAir;
+			}
+			if (psDroid->droidType == DROID_SENSOR)	// special treatment for sensor turrets, no multiweapon support
+			{
+				mode |= SHOOT_ON_GROUND;		// assume it only shoots at ground targets for now
+			}
+			if (mode > 0)
+			{
+				threatSourceAdd(psDroid, mode, enemies);
+			}
+		}
+
+		for (STRUCTURE *psStruct = apsStructLists[i]; psStruct; psStruct = psStruct->psNext)
+		{
+			UBYTE mode = 0;
+
+			for (weapon = 0; weapon < psStruct->numWeaps; weapon++)
+			{
+				mode |= asWeaponStats[psStruct->asWeaps[weapon].nStat].surfaceToAir;
+			}
+			if (psStruct->pStructureType->pSensor && psStruct->pStructureType->pSensor->location == LOC_TURRET)	// special treatment for sensor turrets
+			{
+				mode |= SHOOT_ON_GROUND;		// assume it only shoots at ground targets for now
+			}
+			if (mode > 0)
+			{
+				threatSourceAdd(psStruct, mode, enemies);
+			}
+		}
+	}
+}
+
+// This function runs in a separate thread!
+/// Collects the tiles the player's visible enemies can shoot at from threatSources, and notes whether that changed.
+static void threatSourcesCollect(int player, DangerMap &danger)
+{
+	std::vector<uint32_t> &threats = danger.collected;
+
+	threats.clear();
+	for (std::vector<ThreatSource>::const_iterator source = threatSources.begin(); source != threatSources.end(); ++source)
+	{
+		if ((source->seenBy & 1 << player) != 0)
+		{
+			for (unsigned i = source->firstTile; i < source->firstTile + source->numTiles; i++)
+			{
+				threats.push_back(threatSourceTiles[i] | source->bits);
+			}
+		}
+	}
+
+	if (threats != danger.threats)
+	{
+		danger.threats.swap(threats);
+		danger.threatChanged = true;
+	}
+}
+
+/// Copies the player's aux map, for the danger threads to work on. Must be called from the main thread.
+static void dangerMapStore(int player)
+{
+	DangerMap &danger = dangerMaps[player];
+	danger.aux.assign(psAuxMap[player], psAuxMap[player] + mapWidth * mapHeight);
+	danger.auxChanges = auxChangedTilesStart + auxChangedTiles.size();
+	danger.auxGeneration = auxMapGeneration;
+	danger.auxCopied = true;
+}
+
+/// Copies the threat and danger bits worked out by the danger threads back to the player's aux map. Must be called from the main thread.
+static void dangerMapRestore(int player)
+{
+	DangerMap &danger = dangerMaps[player];
+	if (!danger.updated)
+	{
+		return;  // Nothing changed, so the danger map was not worked out again.
+	}
+	danger.updated = false;
+	if (danger.auxGeneration != auxMapGeneration || danger.aux.size() != (size_t)mapWidth * mapHeight)
+	{
+		return;  // The aux maps were replaced, so the copy is out of date, and will be worked out again next time.
+	}
+
+	int mask = AUXBITS_DANGER;
+	if (danger.threatChanged)
+	{
+		mask |= AUXBITS_THREAT | AUXBITS_AATHREAT;
+		danger.threatChanged = false;
+		++auxThreatChanges[player];
+	}
+	for (int i = 0; i < mapWidth * mapHeight; i++)
+	{
+		uint8_t original = psAuxMap[player][i];
+		psAuxMap[player][i] = original ^ ((original ^ danger.aux[i]) & mask);
+	}
+}
+
+// This function runs in a separate thread!
+static void threatUpdate(DangerMap &danger)
+{
+	uint8_t *aux = &danger.aux[0];
+
+	// Step 1: Clear our threat bits
+	for (int i = 0; i < mapWidth * mapHeight; i++)
+	{
+		aux[i] &= ~(AUXBITS_THREAT | AUXBITS_AATHREAT);
+	}
+
+	// Step 2: Set threat bits
+	for (std::vector<uint32_t>::const_iterator i = danger.threats.begin(); i != danger.threats.end(); ++i)
+	{
+		aux[*i & 0xFFFFFF] |= *i >> 24;
+	}
+}
+
 // This function runs in a separate thread!
-static int dangerFloodFill(int player)
+static void dangerFloodFill(int player, DangerMap &danger, std::vector<floodtile> &floodbucket)
 {
 	int i;
 	Vector2i pos = getPlayerStartPosition(player);
 	Vector2i npos;
 	uint8_t aux, block;
-	int x, y;
+	uint8_t *auxMap = &danger.aux[0];
+	const uint8_t *blockMap = psBlockMap[AUX_DANGERMAP];
+	int bucketcounter;
 	bool start = true;	// hack to disregard the blocking status of any building exactly on the starting position
 
+	floodbucket.resize(mapWidth * mapHeight);
+
 	// Set our danger bits
-	for (y = 0; y < mapHeight; y++)
+	for (i = 0; i < mapWidth * mapHeight; i++)
 	{
-		for (x = 0; x < mapWidth; x++)
-		{
-			auxSet(x, y, MAX_PLAYERS + AUX_DANGERMAP, AUXBITS_DANGER);
-			auxClear(x, y, MAX_PLAYERS + AUX_DANGERMAP, AUXBITS_TEMPORARY);
-		}
+		auxMap[i] = (auxMap[i] | AUXBITS_DANGER) & ~AUXBITS_TEMPORARY;
 	}
 
 	pos.x = map_coord(pos.x);
@@ -1811,8 +2101,8 @@ static int dangerFloodFill(int player)
 			{
 				continue;
 			}
-			aux = auxTile(npos.x, npos.y, MAX_PLAYERS + AUX_DANGERMAP);
-			block = blockTile(pos.x, pos.y, AUX_DANGERMAP);
+			aux = auxMap[npos.x + npos.y * mapWidth];
+			block = blockMap[pos.x + pos.y * mapWidth];
 			if (!(aux & AUXBITS_TEMPORARY) && !(aux & AUXBITS_THREAT) && (aux & AUXBITS_DANGER))
 			{
 				// Note that we do not consider water to be a blocker here. This may or may not be a feature...
@@ -1828,14 +2118,14 @@ static int dangerFloodFill(int player)
 				}
 				else
 				{
-					auxClear(npos.x, npos.y, MAX_PLAYERS + AUX_DANGERMAP, AUXBITS_DANGER);
+					auxMap[npos.x + npos.y * mapWidth] &= ~AUXBITS_DANGER;
 				}
-				auxSet(npos.x, npos.y, MAX_PLAYERS + AUX_DANGERMAP, AUXBITS_TEMPORARY); // make sure we do not process it more than once
+				auxMap[npos.x + npos.y * mapWidth] |= AUXBITS_TEMPORARY; // make sure we do not process it more than once
 			}
 		}
 
 		// Clear danger
-		auxClear(pos.x, pos.y, MAX_PLAYERS + AUX_DANGERMAP, AUXBITS_DANGER);
+		auxMap[pos.x + pos.y * mapWidth] &= ~AUXBITS_DANGER;
 
 		// Pop the last open node off the bucket list for the next iteration
 		if (bucketcounter)
@@ -1846,139 +2136,98 @@ static int dangerFloodFill(int player)
 		}
 	}
 	while (bucketcounter);
-	return 0;
 }
 
 // This function runs in a separate thread!
-static int dangerThreadFunc(WZ_DECL_UNUSED void *data)
-{
-	while (lastDangerPlayer != -1)
-	{
-		dangerFloodFill(lastDangerPlayer);	// Do the actual work
-		wzSemaphorePost(dangerDoneSemaphore);   // Signal that we are done
-		wzSemaphoreWait(dangerSemaphore);	// Go to sleep until needed.
-	}
-	return 0;
-}
-
-static inline void threatUpdateTarget(int player, BASE_OBJECT *psObj, bool ground, bool air)
+static void dangerUpdate(int player, unsigned thread)
 {
-	int i;
+	WzProfileScope profile("dangerUpdate", player);
+	DangerMap &danger = dangerMaps[player];
 
-	if (psObj->visible[player] || psObj->born == 2)
+	threatSourcesCollect(player, danger);
+	if (!danger.threatChanged && !danger.auxCopied)
 	{
-		for (i = 0; i < psObj->numWatchedTiles; i++)
-		{
-			const TILEPOS pos = psObj->watchedTiles[i];
-
-			if (ground)
-			{
-				auxSet(pos.x, pos.y, MAX_PLAYERS + AUX_DANGERMAP, AUXBITS_THREAT);	// set ground threat for this tile
-			}
-			if (air)
-			{
-				auxSet(pos.x, pos.y, MAX_PLAYERS + AUX_DANGERMAP, AUXBITS_AATHREAT);	// set air threat for this tile
-			}
-		}
+		return;  // Neither the threats nor the aux map changed, so the danger map would come out the same.
 	}
+	danger.auxCopied = false;
+	threatUpdate(danger);
+	dangerFloodFill(player, danger, dangerBuckets[thread]);
+	danger.updated = true;
 }
 
-static void threatUpdate(int player)
+// This function runs in a separate thread!
+static int dangerThreadFunc(void *data)
 {
-	int i, weapon, x, y;
+	unsigned thread = (uintptr_t)data;
 
-	// Step 1: Clear our threat bits
-	for (y = 0; y < mapHeight; y++)
+	wzProfileThreadName("danger map");
+	for (;;)
 	{
-		for (x = 0; x < mapWidth; x++)
-		{
-			auxClear(x, y, MAX_PLAYERS + AUX_DANGERMAP, AUXBITS_THREAT | AUXBITS_AATHREAT);
-		}
-	}
-
-	// Step 2: Set threat bits
-	for (i = 0; i < MAX_PLAYERS; i++)
-	{
-		DROID *psDroid;
-		STRUCTURE *psStruct;
-
-		if (aiCheckAlliances(player, i))
+		wzSemaphoreWait(dangerSemaphore);	// Go to sleep until needed.
+		if (dangerQuit)
 		{
-			// No need to iterate friendly objects
-			continue;
+			break;
 		}
-
-		for (psDroid = apsDroidLists[i]; psDroid; psDroid = psDroid->psNext)
+		for (;;)
 		{
-			UBYTE mode = 0;
+			wzMutexLock(dangerMutex);
+			unsigned job = dangerNext++;
+			wzMutexUnlock(dangerMutex);
 
-			if (psDroid->droidType == DROID_CONSTRUCT || psDroid->droidType == DROID_CYBORG_CONSTRUCT
-			    || psDroid->droidType == DROID_REPAIR || psDroid->droidType == DROID_CYBORG_REPAIR)
-			{
-				continue;	// hack that really should not be needed, but is -- trucks can SHOOT_ON_GROUND...!
-			}
-			for (weapon = 0; weapon < psDroid->numWeaps; weapon++)
+			if (job >= dangerJobs.size())
 			{
-				mode |= asWeaponStats[psDroid->asWeaps[weapon].nStat].surfaceToAir;
-			}
-			if (psDroid->droidType == DROID_SENSOR)	// special treatment for sensor turrets, no multiweapon support
-			{
-				mode |= SHOOT_ON_GROUND;		// assume it only shoots at ground targets for now
-			}
-			if (mode > 0)
-			{
-				threatUpdateTarget(player, (BASE_OBJECT *)psDroid, mode & SHOOT_ON_GROUND, mode & SHOOT_IN_AIR);
-			}
-		}
-
-		for (psStruct = apsStructLists[i]; psStruct; psStruct = psStruct->psNext)
-		{
-			UBYTE mode = 0;
-
-			for (weapon = 0; weapon < psStruct->numWeaps; weapon++)
-			{
-				mode |= asWeaponStats[psStruct->asWeaps[weapon].nStat].surfaceToAir;
-			}
-			if (psStruct->pStructureType->pSensor && psStruct->pStructureType->pSensor->location == LOC_TURRET)	// special treatment for sensor turrets
-			{
-				mode |= SHOOT_ON_GROUND;		// assume it only shoots at ground targets for now
-			}
-			if (mode > 0)
-			{
-				threatUpdateTarget(player, (BASE_OBJECT *)psStruct, mode & SHOOT_ON_GROUND, mode & SHOOT_IN_AIR);
+				break;
 			}
+			dangerUpdate(dangerJobs[job], thread);	// Do the actual work
 		}
+		wzSemaphorePost(dangerDoneSemaphore);   // Signal that we are done
 	}
+	return 0;
 }
 
 void mapInit()
 {
 	int player;
 
-	free(floodbucket);
-	floodbucket = (struct floodtile *)malloc(mapWidth * mapHeight * sizeof(*floodbucket));
-
 	lastDangerUpdate = 0;
-	lastDangerPlayer = -1;
+	dangerBuckets.resize(std::max<unsigned>(wzParallelThreadCount(), game.maxPlayers));
+	memcpy(psBlockMap[AUX_DANGERMAP], psBlockMap[AUX_MAP], mapWidth * mapHeight * sizeof(*psBlockMap[0]));
 
 	// Initialize danger maps
+	threatSourcesStore();
+	for (player = 0; player < MAX_PLAYERS; player++)
+	{
+		dangerMaps[player] = DangerMap();
+		dangerMaps[player].threatChanged = true;  // Whatever threat bits the aux map had are from before.
+		dangerMapStore(player);
+	}
+	wzParallelFor(MAX_PLAYERS, [](unsigned begin, unsigned end, unsigned thread) {
+		for (unsigned player = begin; player < end; ++player)
+		{
+			dangerUpdate(player, thread);
+		}
+	});
 	for (player = 0; player < MAX_PLAYERS; player++)
 	{
-		auxMapStore(player, AUX_DANGERMAP);
-		threatUpdate(player);
-		dangerFloodFill(player);
-		auxMapRestore(player, AUX_DANGERMAP, AUXBITS_DANGER | AUXBITS_THREAT | AUXBITS_AATHREAT);
+		dangerMapRestore(player);
 	}
 
-	// Start thread
-	ASSERT(dangerSemaphore == NULL && dangerThread == NULL, "Map data not cleaned up before starting!");
+	// Start threads
+	ASSERT(dangerSemaphore == NULL && dangerThreads.empty(), "Map data not cleaned up before starting!");
 	if (game.type == SKIRMISH)
 	{
-		lastDangerPlayer = 0;
+		// One thread per core not used by the main thread, since the danger maps are worked out while the game runs.
+		int numThreads = clip((int)wzParallelThreadCount() - 1, 1, std::max<int>(game.maxPlayers, 1));
+		dangerQuit = false;
+		dangerRunning = 0;
+		dangerMutex = wzMutexCreate();
 		dangerSemaphore = wzSemaphoreCreate(0);
 		dangerDoneSemaphore = wzSemaphoreCreate(0);
-		dangerThread = wzThreadCreate(dangerThreadFunc, NULL);
-		wzThreadStart(dangerThread);
+		for (int i = 0; i < numThreads; ++i)
+		{
+			dangerThreads.push_back(wzThreadCreate(dangerThreadFunc, (void *)(uintptr_t)i));
+			wzThreadStart(dangerThreads.back());
+		}
 	}
 }
 
@@ -2007,12 +2256,35 @@ void mapUpdate()
 		lastDangerUpdate = gameTime;
 
 		// Lock if previous job not done yet
-		wzSemaphoreWait(dangerDoneSemaphore);
+		dangerWait();
 
-		auxMapRestore(lastDangerPlayer, AUX_DANGERMAP, AUXBITS_THREAT | AUXBITS_AATHREAT | AUXBITS_DANGER);
-		lastDangerPlayer = (lastDangerPlayer + 1) % game.maxPlayers;
-		auxMapStore(lastDangerPlayer, AUX_DANGERMAP);
-		threatUpdate(lastDangerPlayer);
-		wzSemaphorePost(dangerSemaphore);
+		for (std::vector<int>::const_iterator player = dangerJobs.begin(); player != dangerJobs.end(); ++player)
+		{
+			dangerMapRestore(*player);
+		}
+
+		// Each danger thread collects its player's threats from threatSources, and skips the danger map if neither the threats nor the aux map changed.
+		threatSourcesStore();
+		dangerJobs.clear();
+		for (int player = 0; player < game.maxPlayers; player++)
+		{
+			DangerMap &danger = dangerMaps[player];
+			if (danger.auxGeneration != auxMapGeneration || danger.auxChanges != auxChangedTilesStart + auxChangedTiles.size())
+			{
+				dangerMapStore(player);
+			}
+			dangerJobs.push_back(player);
+		}
+		if (!dangerJobs.empty())
+		{
+			syncDebug("Danger maps of %d players, %d threat sources.", (int)dangerJobs.size(), (int)threatSources.size());
+			memcpy(psBlockMap[AUX_DANGERMAP], psBlockMap[AUX_MAP], mapWidth * mapHeight * sizeof(*psBlockMap[0]));
+			dangerNext = 0;
+			dangerRunning = std::min<unsigned>(dangerThreads.size(), dangerJobs.size());
+			for (unsigned i = 0; i < dangerRunning; ++i)
+			{
+				wzSemaphorePost(dangerSemaphore);
+			}
+		}
 	}
 }
@@ -91,22 +91,30 @@ struct GROUND_TYPE
 /* Information stored with each tile */
 struct MAPTILE
 {
+	// Used by the game simulation, kept together at the start.
 	uint8_t			tileInfoBits;
 	PlayerMask              tileExploredBits;
 	PlayerMask              sensorBits;             ///< bit per player, who can see tile with sensor
+	PlayerMask		jammerBits;             ///< bit per player, who is jamming tile
+	uint16_t                fireEndTime;            ///< The (uint16_t)(gameTime / GAME_TICKS_PER_UPDATE) that BITS_ON_FIRE should be cleared.
+	uint16_t		limitedContinent;	///< For land or sea limited propulsion types
+	uint16_t		hoverContinent;		///< For hover type propulsions
+	int32_t                 height;                 ///< The height at the top left of the tile
+	int32_t                 waterLevel;             ///< At what height is the water for this tile
+	BASE_OBJECT		*psObject;		// Any object sitting on the location (e.g. building)
+
+	// Only used for drawing the map.
 	uint8_t			illumination;	// How bright is this tile?
-	uint8_t			watchers[MAX_PLAYERS];		// player sees through fog of war here with this many objects
+	uint8_t			ground;			///< The ground type used for the terrain renderer
 	uint16_t		texture;		// Which graphics texture is on this tile
-	int32_t                 height;                 ///< The height at the top left of the tile
 	float                   level;                  ///< The visibility level of the top left of the tile, for this client.
-	BASE_OBJECT		*psObject;		// Any object sitting on the location (e.g. building)
 	PIELIGHT		colour;
-	uint16_t		limitedContinent;	///< For land or sea limited propulsion types
-	uint16_t		hoverContinent;		///< For hover type propulsions
-	uint8_t			ground;			///< The ground type used for the terrain renderer
-	uint16_t                fireEndTime;            ///< The (uint16_t)(gameTime / GAME_TICKS_PER_UPDATE) that BITS_ON_FIRE should be cleared.
-	int32_t                 waterLevel;             ///< At what height is the water for this tile
-	PlayerMask		jammerBits;             ///< bit per player, who is jamming tile
+};
+
+/// Per-player counts of the objects seeing or jamming a tile. Only the visibility code uses these, so they are kept out of MAPTILE, instead of making every pass over the map skip over them.
+struct TILE_VISION
+{
+	uint8_t                 watchers[MAX_PLAYERS];  ///< player sees through fog of war here with this many objects
 	uint8_t                 sensors[MAX_PLAYERS];   ///< player sees this tile with this many radar sensors
 	uint8_t                 jammers[MAX_PLAYERS];   ///< player jams the tile with this many objects
 };
@@ -114,6 +122,7 @@ struct MAPTILE
 /* The size and contents of the map */
 extern SDWORD	mapWidth, mapHeight;
 extern MAPTILE *psMapTiles;
+extern TILE_VISION *psTileVision;	///< Vision counts of each tile, in the same order as psMapTiles.
 extern float waterLevel;
 extern GROUND_TYPE *psGroundTypes;
 extern int numGroundTypes;
@@ -142,6 +151,28 @@ extern char *tilesetDir;
 extern uint8_t *psBlockMap[AUX_MAX];
 extern uint8_t *psAuxMap[MAX_PLAYERS + AUX_MAX];	// yes, we waste one element... eyes wide open... makes API nicer
 
+/// Tiles (x + y * mapWidth) whose blocking bits changed, in order, so the pathfinding blocking maps can be updated instead of regenerated.
+extern std::vector<uint32_t> auxChangedTiles;
+/// Number of changes forgotten from the start of auxChangedTiles.
+extern size_t auxChangedTilesStart;
+/// Incremented whenever the aux maps are replaced, such as when loading a map or switching to or from an offworld mission.
+extern uint32_t auxMapGeneration;
+/// Incremented whenever the threat bits of a player's aux map change.
+extern uint32_t auxThreatChanges[MAX_PLAYERS];
+
+/// Forgets all recorded changes, since the aux maps were replaced.
+void auxMapReplaced();
+/// Forgets the recorded changes before the given change number, since they are no longer needed.
+void auxForgetChanges(size_t upTo);
+
+/// Incremented whenever the height or water level of a tile changes.
+extern uint32_t mapHeightChanges;
+/// Records that the height or water level of the tile changed, for mapHeightChangedSince().
+void mapHeightChanged(int x, int y);
+/// Whether the height or water level of any tile in the rectangle, in inclusive tile coordinates, changed since mapHeightChanges was the given number.
+/// Changes are recorded in blocks of tiles, so may also be true if only tiles next to the rectangle changed.
+bool mapHeightChangedSince(uint32_t changes, int x1, int y1, int x2, int y2);
+
 /// Find aux bitfield for a given tile
 WZ_DECL_ALWAYS_INLINE static inline uint8_t auxTile(int x, int y, int player)
 {
@@ -154,27 +185,6 @@ WZ_DECL_ALWAYS_INLINE static inline uint8_t blockTile(int x, int y, int slot)
 	return psBlockMap[slot][x + y * mapWidth];
 }
 
-/// Store a shadow copy of a player's aux map for use in threaded calculations
-static inline void auxMapStore(int player, int slot)
-{
-	memcpy(psBlockMap[slot], psBlockMap[0], sizeof(*psBlockMap[player]) * mapWidth * mapHeight);
-	memcpy(psAuxMap[MAX_PLAYERS + slot], psAuxMap[player], sizeof(*psAuxMap[player]) * mapWidth * mapHeight);
-}
-
-/// Restore selected fields from the shadow copy of a player's aux map (ignoring the block map)
-static inline void auxMapRestore(int player, int slot, int mask)
-{
-	int i;
-	uint8_t original, cached;
-
-	for (i = 0; i < mapHeight * mapWidth; i++)
-	{
-		original = psAuxMap[player][i];
-		cached = psAuxMap[MAX_PLAYERS + slot][i];
-		psAuxMap[player][i] = original ^ ((original ^ cached) & mask);
-	}
-}
-
 /// Set aux bits. Always set identically for all players. States not set are retained.
 WZ_DECL_ALWAYS_INLINE static inline void auxSet(int x, int y, int player, int state)
 {
@@ -190,6 +200,7 @@ WZ_DECL_ALWAYS_INLINE static inline void auxSetAll(int x, int y, int state)
 	{
 		psAuxMap[i][x + y * mapWidth] |= state;
 	}
+	auxChangedTiles.push_back(x + y * mapWidth);
 }
 
 /// Set aux bits. Always set identically for all players. States not set are retained.
@@ -204,6 +215,7 @@ WZ_DECL_ALWAYS_INLINE static inline void auxSetAllied(int x, int y, int player,
 			psAuxMap[i][x + y * mapWidth] |= state;
 		}
 	}
+	auxChangedTiles.push_back(x + y * mapWidth);
 }
 
 /// Set aux bits. Always set identically for all players. States not set are retained.
@@ -218,6 +230,7 @@ WZ_DECL_ALWAYS_INLINE static inline void auxSetEnemy(int x, int y, int player, i
 			psAuxMap[i][x + y * mapWidth] |= state;
 		}
 	}
+	auxChangedTiles.push_back(x + y * mapWidth);
 }
 
 /// Clear aux bits. Always set identically for all players. States not cleared are retained.
@@ -235,18 +248,21 @@ WZ_DECL_ALWAYS_INLINE static inline void auxClearAll(int x, int y, int state)
 	{
 		psAuxMap[i][x + y * mapWidth] &= ~state;
 	}
+	auxChangedTiles.push_back(x + y * mapWidth);
 }
 
 /// Set blocking bits. Always set identically for all players. States not set are retained.
 WZ_DECL_ALWAYS_INLINE static inline void auxSetBlocking(int x, int y, int state)
 {
 	psBlockMap[0][x + y * mapWidth] |= state;
+	auxChangedTiles.push_back(x + y * mapWidth);
 }
 
 /// Clear blocking bits. Always set identically for all players. States not cleared are retained.
 WZ_DECL_ALWAYS_INLINE static inline void auxClearBlocking(int x, int y, int state)
 {
 	psBlockMap[0][x + y * mapWidth] &= ~state;
+	auxChangedTiles.push_back(x + y * mapWidth);
 }
 
 /**
@@ -441,6 +457,12 @@ static inline WZ_DECL_PURE MAPTILE *mapTile(Vector2i const &v)
 	return mapTile(v.x, v.y);
 }
 
+/** Return a pointer to the vision counts of a tile returned by mapTile */
+static inline WZ_DECL_PURE TILE_VISION *tileVision(MAPTILE const *psTile)
+{
+	return &psTileVision[psTile - psMapTiles];
+}
+
 /** Return a pointer to the tile structure at x,y in world coordinates */
 static inline WZ_DECL_PURE MAPTILE *worldTile(int32_t x, int32_t y)
 {
@@ -490,6 +512,7 @@ static inline void setTileHeight(int32_t x, int32_t y, int32_t height)
 
 	psMapTiles[x + (y * mapWidth)].height = height;
 	markTileDirty(x, y);
+	mapHeightChanged(x, y);
 }
 
 /* Return whether a tile coordinate is on the map */
@@ -25,34 +25,210 @@
  *
  */
 #include "lib/framework/types.h"
+#include "lib/framework/trig.h"
 #include "objects.h"
 #include "map.h"
 
 #include "mapgrid.h"
 #include "pointtree.h"
 
+#include <algorithm>
+#include <unordered_set>
+
 
 static PointTree *gridPointTree = NULL;  // A quad-tree-like object.
-static PointTree::Filter *gridFiltersUnseen;
-static PointTree::Filter *gridFiltersDroidsByPlayer;
+static unsigned gridResets = 0;          // Changed whenever the objects in the grid change.
+static GridQuery gridMainQuery;          // Used by the gridStartIterate functions.
+
+/// An object in gridStaticPointTree, as it was when it was put there.
+struct GridStaticObject
+{
+	bool operator ==(GridStaticObject const &b) const
+	{
+		return psObj == b.psObj && id == b.id && pos == b.pos;
+	}
+
+	BASE_OBJECT *psObj;  ///< Might have been freed since, so only compare the pointer.
+	uint32_t id;
+	Vector2i pos;
+};
+
+struct GridStaticObjectHash
+{
+	size_t operator ()(GridStaticObject const &obj) const
+	{
+		return std::hash<void *>()(obj.psObj) ^ obj.id;
+	}
+};
+
+/// A droid in gridDroidPointTree. The id tells it apart from a new droid which was allocated where a dead one used to be.
+struct GridDroid
+{
+	bool operator ==(GridDroid const &b) const
+	{
+		return psObj == b.psObj && id == b.id;
+	}
+
+	BASE_OBJECT *psObj;  ///< Might have been freed since, so only compare the pointer.
+	uint32_t id;
+};
+
+struct GridDroidHash
+{
+	size_t operator ()(GridDroid const &droid) const
+	{
+		return std::hash<void *>()(droid.psObj) ^ droid.id;
+	}
+};
+
+// gridPointTree is merged from these two every update, which is much faster than sorting all the objects again.
+static PointTree gridStaticPointTree;                      ///< Structures and features, which don't move. Only changes when they are built or destroyed.
+static std::vector<GridStaticObject> gridStaticObjects;    ///< The objects in gridStaticPointTree, in list order.
+static PointTree gridDroidPointTree;                       ///< Droids, still mostly sorted from the last update.
+static std::vector<GridDroid> gridDroids;                  ///< The droids in gridDroidPointTree, in list order.
 
 // initialise the grid system
 bool gridInitialise(void)
 {
 	ASSERT(gridPointTree == NULL, "gridInitialise already called, without calling gridShutDown.");
 	gridPointTree = new PointTree;
-	gridFiltersUnseen = new PointTree::Filter[MAX_PLAYERS];
-	gridFiltersDroidsByPlayer = new PointTree::Filter[MAX_PLAYERS];
+	++gridResets;
 
 	return true;  // Yay, nothing failed!
 }
 
+/// Updates gridStaticPointTree, if any structures or features were built or destroyed since the last time.
+static void gridUpdateStatic()
+{
+	static std::vector<GridStaticObject> objects;  // static to avoid allocations.
+
+	objects.clear();
+	for (unsigned player = 0; player < MAX_PLAYERS; player++)
+	{
+		BASE_OBJECT *start[2] = {(BASE_OBJECT *)apsStructLists[player], (BASE_OBJECT *)apsFeatureLists[player]};
+		for (unsigned type = 0; type != sizeof(start) / sizeof(*start); ++type)
+		{
+			for (BASE_OBJECT *psObj = start[type]; psObj != NULL; psObj = psObj->psNext)
+			{
+				if (!psObj->died)
+				{
+					GridStaticObject obj = {psObj, psObj->id, psObj->pos.xy};
+					objects.push_back(obj);
+				}
+			}
+		}
+	}
+	if (objects == gridStaticObjects)
+	{
+		return;  // Nothing changed.
+	}
+
+	std::unordered_set<GridStaticObject, GridStaticObjectHash> before(gridStaticObjects.begin(), gridStaticObjects.end());
+	std::unordered_set<GridStaticObject, GridStaticObjectHash> after(objects.begin(), objects.end());
+	std::unordered_set<void *> removed;
+	for (unsigned i = 0; i < gridStaticObjects.size(); ++i)
+	{
+		if (after.count(gridStaticObjects[i]) == 0)
+		{
+			removed.insert(gridStaticObjects[i].psObj);
+		}
+	}
+	PointTree added;
+	for (unsigned i = 0; i < objects.size(); ++i)
+	{
+		if (before.count(objects[i]) == 0)
+		{
+			added.insert(objects[i].psObj, objects[i].pos.x, objects[i].pos.y);
+		}
+	}
+	added.sort();
+
+	if (!removed.empty())
+	{
+		gridStaticPointTree.erase([&](void *pointData) {
+			return removed.count(pointData) != 0;
+		});
+	}
+	if (!added.empty())
+	{
+		PointTree merged;
+		merged.merge(gridStaticPointTree, added);
+		std::swap(gridStaticPointTree, merged);
+	}
+	gridStaticObjects.swap(objects);
+}
+
+/// Updates gridDroidPointTree with where the droids are now.
+static void gridUpdateDroids()
+{
+	static std::vector<GridDroid> droids;  // static to avoid allocations.
+
+	droids.clear();
+	for (unsigned player = 0; player < MAX_PLAYERS; player++)
+	{
+		for (DROID *psDroid = apsDroidLists[player]; psDroid != NULL; psDroid = psDroid->psNext)
+		{
+			if (!psDroid->died)
+			{
+				GridDroid droid = {psDroid, psDroid->id};
+				droids.push_back(droid);
+			}
+		}
+	}
+
+	PointTree added;
+	if (droids != gridDroids)
+	{
+		// Remove droids that are gone first, since they might have been freed. Droids are matched by id too, since a new
+		// droid may have been allocated at the same address, which must not inherit the old droid's place among equal points.
+		std::unordered_set<GridDroid, GridDroidHash> before(gridDroids.begin(), gridDroids.end());
+		std::unordered_set<GridDroid, GridDroidHash> after(droids.begin(), droids.end());
+		std::unordered_set<void *> removed;
+		for (unsigned i = 0; i < gridDroids.size(); ++i)
+		{
+			if (after.count(gridDroids[i]) == 0)
+			{
+				removed.insert(gridDroids[i].psObj);
+			}
+		}
+		if (!removed.empty())
+		{
+			gridDroidPointTree.erase([&](void *pointData) {
+				return removed.count(pointData) != 0;
+			});
+		}
+		for (unsigned i = 0; i < droids.size(); ++i)
+		{
+			if (before.count(droids[i]) == 0)
+			{
+				added.insert(droids[i].psObj, droids[i].psObj->pos.x, droids[i].psObj->pos.y);
+			}
+		}
+		added.sort();
+		gridDroids.swap(droids);
+	}
+
+	gridDroidPointTree.move([](void *pointData) {
+		return static_cast<BASE_OBJECT *>(pointData)->pos.xy;
+	});
+
+	if (!added.empty())
+	{
+		PointTree merged;
+		merged.merge(gridDroidPointTree, added);
+		std::swap(gridDroidPointTree, merged);
+	}
+}
+
 // reset the grid system
 void gridReset(void)
 {
-	gridPointTree->clear();
-
 	// Put all existing objects into the point tree.
+	gridUpdateStatic();
+	gridUpdateDroids();
+	gridPointTree->merge(gridStaticPointTree, gridDroidPointTree);
+	++gridResets;
+
 	for (unsigned player = 0; player < MAX_PLAYERS; player++)
 	{
 		BASE_OBJECT *start[3] = {(BASE_OBJECT *)apsDroidLists[player], (BASE_OBJECT *)apsStructLists[player], (BASE_OBJECT *)apsFeatureLists[player]};
@@ -62,7 +238,6 @@ void gridReset(void)
 			{
 				if (!psObj->died)
 				{
-					gridPointTree->insert(psObj, psObj->pos.x, psObj->pos.y);
 					for (unsigned viewer = 0; viewer < MAX_PLAYERS; ++viewer)
 					{
 						psObj->seenThisTick[viewer] = 0;
@@ -71,14 +246,12 @@ void gridReset(void)
 			}
 		}
 	}
+	// The GridQuery filters reset themselves, since gridPointTree changed.
+}
 
-	gridPointTree->sort();
-
-	for (unsigned player = 0; player < MAX_PLAYERS; ++player)
-	{
-		gridFiltersUnseen[player].reset(*gridPointTree);
-		gridFiltersDroidsByPlayer[player].reset(*gridPointTree);
-	}
+unsigned gridGeneration()
+{
+	return gridResets;
 }
 
 // shutdown the grid system
@@ -86,10 +259,11 @@ void gridShutDown(void)
 {
 	delete gridPointTree;
 	gridPointTree = NULL;
-	delete[] gridFiltersUnseen;
-	gridFiltersUnseen = NULL;
-	delete[] gridFiltersDroidsByPlayer;
-	gridFiltersDroidsByPlayer = NULL;
+	gridStaticPointTree.clear();
+	gridStaticObjects.clear();
+	gridDroidPointTree.clear();
+	gridDroids.clear();
+	++gridResets;
 }
 
 static bool isInRadius(int32_t x, int32_t y, uint32_t radius)
@@ -97,59 +271,35 @@ static bool isInRadius(int32_t x, int32_t y, uint32_t radius)
 	return (uint32_t)(x * x + y * y) <= radius * radius;
 }
 
-// initialise the grid system to start iterating through units that
-// could affect a location (x,y in world coords)
 template<class Condition>
-static GridList const &gridStartIterateFiltered(int32_t x, int32_t y, uint32_t radius, PointTree::Filter *filter, Condition const &condition)
+GridList const &GridQuery::findFiltered(int32_t x, int32_t y, uint32_t radius, PointTree::Filter *filter, Condition const &condition)
 {
 	if (filter == NULL)
 	{
-		gridPointTree->query(x, y, radius);
+		gridPointTree->query(points, x, y, radius);
 	}
 	else
 	{
-		gridPointTree->query(*filter, x, y, radius);
+		gridPointTree->query(points, indices, *filter, x, y, radius);
 	}
-	PointTree::ResultVector::iterator w = gridPointTree->lastQueryResults.begin(), i;
-	for (i = w; i != gridPointTree->lastQueryResults.end(); ++i)
+	list.clear();
+	for (unsigned i = 0; i != points.size(); ++i)
 	{
-		BASE_OBJECT *obj = static_cast<BASE_OBJECT *>(*i);
+		BASE_OBJECT *obj = static_cast<BASE_OBJECT *>(points[i]);
 		if (!condition.test(obj))  // Check if we should skip this object.
 		{
-			filter->erase(gridPointTree->lastFilteredQueryIndices[i - gridPointTree->lastQueryResults.begin()]);  // Stop the object from appearing in future searches.
+			filter->erase(indices[i]);  // Stop the object from appearing in future searches.
 		}
 		else if (isInRadius(obj->pos.x - x, obj->pos.y - y, radius))  // Check that search result is less than radius (since they can be up to a factor of sqrt(2) more).
 		{
-			*w = *i;
-			++w;
+			list.push_back(obj);
 		}
 	}
-	gridPointTree->lastQueryResults.erase(w, i);  // Erase all points that were a bit too far.
 	/*
 	// In case you are curious.
-	debug(LOG_WARNING, "gridStartIterateFiltered(%d, %d, %u) found %u objects", x, y, radius, (unsigned)gridPointTree->lastQueryResults.size());
+	debug(LOG_WARNING, "GridQuery::findFiltered(%d, %d, %u) found %u objects", x, y, radius, (unsigned)list.size());
 	*/
-	static GridList gridList;
-	gridList.resize(gridPointTree->lastQueryResults.size());
-	for (unsigned n = 0; n < gridList.size(); ++n)
-	{
-		gridList[n] = (BASE_OBJECT *)gridPointTree->lastQueryResults[n];
-	}
-	return gridList;
-}
-
-template<class Condition>
-static GridList const &gridStartIterateFilteredArea(int32_t x, int32_t y, int32_t x2, int32_t y2, Condition const &condition)
-{
-	gridPointTree->query(x, y, x2, y2);
-
-	static GridList gridList;
-	gridList.resize(gridPointTree->lastQueryResults.size());
-	for (unsigned n = 0; n < gridList.size(); ++n)
-	{
-		gridList[n] = (BASE_OBJECT *)gridPointTree->lastQueryResults[n];
-	}
-	return gridList;
+	return list;
 }
 
 struct ConditionTrue
@@ -160,14 +310,20 @@ struct ConditionTrue
 	}
 };
 
-GridList const &gridStartIterate(int32_t x, int32_t y, uint32_t radius)
+GridList const &GridQuery::find(int32_t x, int32_t y, uint32_t radius)
 {
-	return gridStartIterateFiltered(x, y, radius, NULL, ConditionTrue());
+	return findFiltered(x, y, radius, NULL, ConditionTrue());
 }
 
-GridList const &gridStartIterateArea(int32_t x, int32_t y, uint32_t x2, uint32_t y2)
+GridList const &GridQuery::findArea(int32_t x, int32_t y, int32_t x2, int32_t y2)
 {
-	return gridStartIterateFilteredArea(x, y, x2, y2, ConditionTrue());
+	gridPointTree->query(points, x, y, x2, y2);
+	list.resize(points.size());
+	for (unsigned n = 0; n < list.size(); ++n)
+	{
+		list[n] = static_cast<BASE_OBJECT *>(points[n]);
+	}
+	return list;
 }
 
 struct ConditionDroidsByPlayer
@@ -180,9 +336,9 @@ struct ConditionDroidsByPlayer
 	int player;
 };
 
-GridList const &gridStartIterateDroidsByPlayer(int32_t x, int32_t y, uint32_t radius, int player)
+GridList const &GridQuery::findDroidsByPlayer(int32_t x, int32_t y, uint32_t radius, int player)
 {
-	return gridStartIterateFiltered(x, y, radius, &gridFiltersDroidsByPlayer[player], ConditionDroidsByPlayer(player));
+	return findFiltered(x, y, radius, &filtersDroidsByPlayer[player], ConditionDroidsByPlayer(player));
 }
 
 struct ConditionUnseen
@@ -195,15 +351,177 @@ struct ConditionUnseen
 	int player;
 };
 
+GridList const &GridQuery::findUnseen(int32_t x, int32_t y, uint32_t radius, int player)
+{
+	return findFiltered(x, y, radius, &filtersUnseen[player], ConditionUnseen(player));
+}
+
+#define GRID_NEAREST_FIRST_RING (TILE_UNITS * 4)  ///< Radius of the first ring searched by searchNearestFirst, which doubles with each ring.
+
+/// Calls visit(object, distSq) on the objects within radius, nearest first, until visit returns false. Objects at the same distance
+/// are visited in the order find() would give them, since queries return points in the order of the tree.
+/// Before searching each ring after the first, calls keepGoing(dist), where dist is the distance to the nearest object that could be in the ring.
+template<class KeepGoing, class Visit>
+void GridQuery::searchNearestFirst(int32_t x, int32_t y, uint32_t radius, KeepGoing const &keepGoing, Visit const &visit)
+{
+	uint32_t inner = 0;
+	uint32_t ring = std::min<uint32_t>(radius, GRID_NEAREST_FIRST_RING);
+	for (bool first = true;; first = false)
+	{
+		gridPointTree->query(points, x, y, ring);
+		nearest.clear();
+		for (unsigned i = 0; i != points.size(); ++i)
+		{
+			BASE_OBJECT *obj = static_cast<BASE_OBJECT *>(points[i]);
+			int32_t dx = obj->pos.x - x, dy = obj->pos.y - y;
+			uint32_t distSq = dx * dx + dy * dy;
+			if (distSq <= ring * ring && (first || distSq > inner * inner))  // Only objects in this ring, since the inner rings were already searched.
+			{
+				nearest.push_back(std::make_pair(distSq, obj));
+			}
+		}
+		std::stable_sort(nearest.begin(), nearest.end(), [](std::pair<uint32_t, BASE_OBJECT *> const &a, std::pair<uint32_t, BASE_OBJECT *> const &b) {
+			return a.first < b.first;
+		});
+		for (unsigned i = 0; i != nearest.size(); ++i)
+		{
+			if (!visit(nearest[i].second, nearest[i].first))
+			{
+				return;
+			}
+		}
+		if (ring >= radius || !keepGoing(ring))
+		{
+			return;
+		}
+		inner = ring;
+		ring = std::min(radius, ring * 2);
+	}
+}
+
+GridList const &GridQuery::findNearest(int32_t x, int32_t y, uint32_t radius, unsigned count, std::function<bool (BASE_OBJECT *, uint32_t distSq)> const &accept)
+{
+	list.clear();
+	if (count == 0)
+	{
+		return list;
+	}
+	searchNearestFirst(x, y, radius, [](int32_t) {
+		return true;
+	}, [&](BASE_OBJECT *obj, uint32_t distSq) {
+		if (accept(obj, distSq))
+		{
+			list.push_back(obj);
+		}
+		return list.size() < count;
+	});
+	return list;
+}
+
+/// Finds the best scoring object for findBest and findBestAmong, which must visit the objects nearest first.
+class GridBestObject
+{
+public:
+	GridBestObject(int minScore, std::function<int (BASE_OBJECT *, uint32_t distSq)> const &score_, std::function<int (int32_t dist)> const &maxScore_)
+		: best(NULL), bestScore(minScore), score(score_), maxScore(maxScore_)
+	{}
+
+	/// Whether something at least dist away could still win.
+	bool keepGoing(int32_t dist) const
+	{
+		return best == NULL || maxScore(dist) > bestScore;
+	}
+
+	/// Returns false if neither obj nor anything further away could win.
+	bool visit(BASE_OBJECT *obj, uint32_t distSq)
+	{
+		if (best != NULL && maxScore(iSqrt(distSq)) <= bestScore)
+		{
+			return false;  // Nothing this far away or further could win.
+		}
+		int objScore = score(obj, distSq);
+		if (objScore > bestScore || (best == NULL && objScore == bestScore))
+		{
+			best = obj;
+			bestScore = objScore;
+		}
+		return true;
+	}
+
+	BASE_OBJECT *best;
+
+private:
+	int bestScore;
+	std::function<int (BASE_OBJECT *, uint32_t distSq)> const &score;
+	std::function<int (int32_t dist)> const &maxScore;
+};
+
+BASE_OBJECT *GridQuery::findBest(int32_t x, int32_t y, uint32_t radius, int minScore, std::function<int (BASE_OBJECT *, uint32_t distSq)> const &score, std::function<int (int32_t dist)> const &maxScore)
+{
+	GridBestObject best(minScore, score, maxScore);
+	// Objects are visited nearest first, so an object only wins if it scores strictly higher than everything before it.
+	searchNearestFirst(x, y, radius, [&](int32_t dist) {
+		return best.keepGoing(dist);
+	}, [&](BASE_OBJECT *obj, uint32_t distSq) {
+		return best.visit(obj, distSq);
+	});
+	return best.best;
+}
+
+BASE_OBJECT *GridQuery::findBestAmong(GridList const &objects, int32_t x, int32_t y, uint32_t radius, int minScore, std::function<int (BASE_OBJECT *, uint32_t distSq)> const &score, std::function<int (int32_t dist)> const &maxScore)
+{
+	nearest.clear();
+	for (unsigned i = 0; i != objects.size(); ++i)
+	{
+		BASE_OBJECT *obj = objects[i];
+		int32_t dx = obj->pos.x - x, dy = obj->pos.y - y;
+		uint32_t distSq = dx * dx + dy * dy;
+		if (distSq <= radius * radius)
+		{
+			nearest.push_back(std::make_pair(distSq, obj));
+		}
+	}
+	std::stable_sort(nearest.begin(), nearest.end(), [](std::pair<uint32_t, BASE_OBJECT *> const &a, std::pair<uint32_t, BASE_OBJECT *> const &b) {
+		return a.first < b.first;
+	});
+
+	GridBestObject best(minScore, score, maxScore);
+	for (unsigned i = 0; i != nearest.size() && best.visit(nearest[i].second, nearest[i].first); ++i)
+	{}
+	return best.best;
+}
+
+GridList const &gridStartIterate(int32_t x, int32_t y, uint32_t radius)
+{
+	return gridMainQuery.find(x, y, radius);
+}
+
+GridList const &gridStartIterateArea(int32_t x, int32_t y, uint32_t x2, uint32_t y2)
+{
+	return gridMainQuery.findArea(x, y, x2, y2);
+}
+
+GridList const &gridStartIterateDroidsByPlayer(int32_t x, int32_t y, uint32_t radius, int player)
+{
+	return gridMainQuery.findDroidsByPlayer(x, y, radius, player);
+}
+
 GridList const &gridStartIterateUnseen(int32_t x, int32_t y, uint32_t radius, int player)
 {
-	return gridStartIterateFiltered(x, y, radius, &gridFiltersUnseen[player], ConditionUnseen(player));
+	return gridMainQuery.findUnseen(x, y, radius, player);
+}
+
+GridList const &gridStartIterateNearest(int32_t x, int32_t y, uint32_t radius, unsigned count, std::function<bool (BASE_OBJECT *, uint32_t distSq)> const &accept)
+{
+	return gridMainQuery.findNearest(x, y, radius, count, accept);
+}
+
+BASE_OBJECT *gridFindBest(int32_t x, int32_t y, uint32_t radius, int minScore, std::function<int (BASE_OBJECT *, uint32_t distSq)> const &score, std::function<int (int32_t dist)> const &maxScore)
+{
+	return gridMainQuery.findBest(x, y, radius, minScore, score, maxScore);
 }
 
-BASE_OBJECT **gridIterateDup(void)
+BASE_OBJECT *gridFindBestAmong(GridList const &objects, int32_t x, int32_t y, uint32_t radius, int minScore, std::function<int (BASE_OBJECT *, uint32_t distSq)> const &score, std::function<int (int32_t dist)> const &maxScore)
 {
-	size_t bytes = gridPointTree->lastQueryResults.size() * sizeof(void *);
-	BASE_OBJECT **ret = (BASE_OBJECT **)malloc(bytes);
-	memcpy(ret, &gridPointTree->lastQueryResults[0], bytes);
-	return ret;
+	return gridMainQuery.findBestAmong(objects, x, y, radius, minScore, score, maxScore);
 }
@@ -24,10 +24,50 @@
 #ifndef __INCLUDED_SRC_MAPGRID_H__
 #define __INCLUDED_SRC_MAPGRID_H__
 
+#include "pointtree.h"
+
+#include <functional>
 
 typedef std::vector<BASE_OBJECT *> GridList;
 typedef GridList::const_iterator GridIterator;
 
+/// Finds objects in the grid, using its own buffers and filters. So several threads can search the grid at once,
+/// if each has its own GridQuery, and the grid isn't reset meanwhile. The results are valid until the next search.
+class GridQuery
+{
+public:
+	/// Find all objects within radius.
+	GridList const &find(int32_t x, int32_t y, uint32_t radius);
+	/// Find all objects within the rectangle.
+	GridList const &findArea(int32_t x, int32_t y, int32_t x2, int32_t y2);
+	/// Find all objects within radius where object->type == OBJ_DROID && object->player == player.
+	GridList const &findDroidsByPlayer(int32_t x, int32_t y, uint32_t radius, int player);
+	/// Find all objects within radius where object->seenThisTick[player] != 255.
+	GridList const &findUnseen(int32_t x, int32_t y, uint32_t radius, int player);
+	/// Find the count nearest objects within radius where accept(object, distSq) is true, nearest first. Objects at the same distance are in the order find() would give them.
+	/// Searches outwards from (x, y), so stops early once enough objects are found.
+	GridList const &findNearest(int32_t x, int32_t y, uint32_t radius, unsigned count, std::function<bool (BASE_OBJECT *, uint32_t distSq)> const &accept);
+	/// Find the object within radius with the highest score(object, distSq), skipping objects scoring less than minScore. Returns NULL if there are none.
+	/// Where scores are equal, the nearest object wins, and then the first in the order find() would give them.
+	/// maxScore(dist) must be at least the score of any object dist or further away, so that the search can stop once no object further away could win.
+	BASE_OBJECT *findBest(int32_t x, int32_t y, uint32_t radius, int minScore, std::function<int (BASE_OBJECT *, uint32_t distSq)> const &score, std::function<int (int32_t dist)> const &maxScore);
+	/// Like findBest, but only looks at the given objects, which must be in the order find() would give them, for example from an earlier findArea().
+	BASE_OBJECT *findBestAmong(GridList const &objects, int32_t x, int32_t y, uint32_t radius, int minScore, std::function<int (BASE_OBJECT *, uint32_t distSq)> const &score, std::function<int (int32_t dist)> const &maxScore);
+
+private:
+	template<class Condition>
+	GridList const &findFiltered(int32_t x, int32_t y, uint32_t radius, PointTree::Filter *filter, Condition const &condition);
+	template<class KeepGoing, class Visit>
+	void searchNearestFirst(int32_t x, int32_t y, uint32_t radius, KeepGoing const &keepGoing, Visit const &visit);
+
+	PointTree::ResultVector points;
+	PointTree::IndexVector indices;
+	PointTree::Filter filtersUnseen[MAX_PLAYERS];
+	PointTree::Filter filtersDroidsByPlayer[MAX_PLAYERS];
+	std::vector<std::pair<uint32_t, BASE_OBJECT *>> nearest;  ///< Objects in the current ring of searchNearestFirst, with their squared distances.
+	GridList list;
+};
+
 
 // initialise the grid system
 extern bool gridInitialise(void);
@@ -39,6 +79,11 @@ extern void gridShutDown(void);
 // Resets seenThisTick[] to false.
 extern void gridReset(void);
 
+/// Changes whenever the grid is reset, initialised or shut down, so that results of searching the grid can be kept until then.
+unsigned gridGeneration();
+
+// The gridStartIterate functions share one GridQuery, so must only be used by the main thread.
+
 /// Find all objects within radius.
 GridList const &gridStartIterate(int32_t x, int32_t y, uint32_t radius);
 
@@ -53,4 +98,12 @@ GridList const &gridStartIterateDroidsByPlayer(int32_t x, int32_t y, uint32_t ra
 /// Find all objects within radius where object->seenThisTick[player] != 255.
 GridList const &gridStartIterateUnseen(int32_t x, int32_t y, uint32_t radius, int player);
 
+// Used for choosing targets.
+/// Find the count nearest objects within radius where accept(object, distSq) is true, nearest first.
+GridList const &gridStartIterateNearest(int32_t x, int32_t y, uint32_t radius, unsigned count, std::function<bool (BASE_OBJECT *, uint32_t distSq)> const &accept);
+/// Find the object within radius with the highest score, see GridQuery::findBest.
+BASE_OBJECT *gridFindBest(int32_t x, int32_t y, uint32_t radius, int minScore, std::function<int (BASE_OBJECT *, uint32_t distSq)> const &score, std::function<int (int32_t dist)> const &maxScore);
+/// Find the object among objects within radius with the highest score, see GridQuery::findBestAmong.
+BASE_OBJECT *gridFindBestAmong(GridList const &objects, int32_t x, int32_t y, uint32_t radius, int minScore, std::function<int (BASE_OBJECT *, uint32_t distSq)> const &score, std::function<int (int32_t dist)> const &maxScore);
+
 #endif // __INCLUDED_SRC_MAPGRID_H__
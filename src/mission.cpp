@@ -330,6 +330,7 @@ bool missionShutDown(void)
 		mission.apsOilList[0] = NULL;
 
 		psMapTiles = mission.psMapTiles;
+		psTileVision = mission.psTileVision;
 		mapWidth = mission.mapWidth;
 		mapHeight = mission.mapHeight;
 		for (int i = 0; i < ARRAY_SIZE(mission.psBlockMap); ++i)
@@ -344,6 +345,7 @@ bool missionShutDown(void)
 			psAuxMap[i] = mission.psAuxMap[i];
 			mission.psAuxMap[i] = NULL;
 		}
+		auxMapReplaced();
 		std::swap(mission.psGateways, gwGetGateways());
 	}
 
@@ -711,6 +713,7 @@ static void saveMissionData(void)
 
 	//save the mission data
 	mission.psMapTiles = psMapTiles;
+	mission.psTileVision = psTileVision;
 	mission.mapWidth = mapWidth;
 	mission.mapHeight = mapHeight;
 	for (int i = 0; i < ARRAY_SIZE(mission.psBlockMap); ++i)
@@ -784,6 +787,7 @@ static void saveMissionData(void)
 		}
 	}
 
+	// The built structure counts follow the lists: loadGame recounts them for the off-world map, and restoreMissionData for the home base.
 	for (inc = 0; inc < MAX_PLAYERS; inc++)
 	{
 		mission.apsStructLists[inc] = apsStructLists[inc];
@@ -866,6 +870,7 @@ void restoreMissionData(void)
 	//swap mission data over
 
 	psMapTiles = mission.psMapTiles;
+	psTileVision = mission.psTileVision;
 
 	mapWidth = mission.mapWidth;
 	mapHeight = mission.mapHeight;
@@ -879,6 +884,7 @@ void restoreMissionData(void)
 		psAuxMap[i] = mission.psAuxMap[i];
 		mission.psAuxMap[i] = NULL;
 	}
+	auxMapReplaced();
 	scrollMinX = mission.scrollMinX;
 	scrollMinY = mission.scrollMinY;
 	scrollMaxX = mission.scrollMaxX;
@@ -886,6 +892,7 @@ void restoreMissionData(void)
 	std::swap(mission.psGateways, gwGetGateways());
 	//and clear the mission pointers
 	mission.psMapTiles	= NULL;
+	mission.psTileVision	= NULL;
 	mission.mapWidth	= 0;
 	mission.mapHeight	= 0;
 	mission.scrollMinX	= 0;
@@ -1373,6 +1380,7 @@ void swapMissionPointers(void)
 	debug(LOG_SAVE, "called");
 
 	std::swap(psMapTiles, mission.psMapTiles);
+	std::swap(psTileVision, mission.psTileVision);
 	std::swap(mapWidth,   mission.mapWidth);
 	std::swap(mapHeight,  mission.mapHeight);
 	for (int i = 0; i < ARRAY_SIZE(mission.psBlockMap); ++i)
@@ -1383,6 +1391,7 @@ void swapMissionPointers(void)
 	{
 		std::swap(psAuxMap[i],   mission.psAuxMap[i]);
 	}
+	auxMapReplaced();
 	//swap gateway zones
 	std::swap(mission.psGateways, gwGetGateways());
 	std::swap(scrollMinX, mission.scrollMinX);
@@ -99,10 +99,57 @@
 #define EXTRA_BITS                              8
 #define EXTRA_PRECISION                         (1 << EXTRA_BITS)
 
+// How far around a droid to look for neighbours, once per update. Covers the largest radius checked, OBJ_MAXRADIUS,
+// plus a tile for the droid moving during the update.
+#define MOVE_NEIGHBOUR_DIST	(OBJ_MAXRADIUS + TILE_UNITS)
+
+/// The objects near the droid being updated by moveUpdateDroid. Found once by the first check that wants them,
+/// and then shared by the others, instead of each check searching the grid again.
+struct MoveNeighbours
+{
+	DROID *psDroid;    ///< The droid being updated.
+	bool found;        ///< Whether objects have been found yet, this update.
+	Vector2i pos;      ///< Where psDroid was when the objects were found.
+	GridList objects;  ///< Objects within MOVE_NEIGHBOUR_DIST of pos, in grid order.
+};
+static MoveNeighbours moveNeighbours = {NULL, false, Vector2i(0, 0), GridList()};
+
 
 /* Function prototypes */
 static void	moveUpdatePersonModel(DROID *psDroid, SDWORD speed, uint16_t direction);
 
+/// Writes the objects within radius of psDroid to neighbours, in grid order. If psDroid is being updated, picks them from
+/// moveNeighbours, searching the grid only the first time.
+static void moveGetNeighbours(DROID *psDroid, int32_t radius, GridList &neighbours)
+{
+	if (psDroid != moveNeighbours.psDroid)
+	{
+		neighbours = gridStartIterate(psDroid->pos.x, psDroid->pos.y, radius);
+		return;
+	}
+	if (!moveNeighbours.found)
+	{
+		moveNeighbours.objects = gridStartIterate(psDroid->pos.x, psDroid->pos.y, MOVE_NEIGHBOUR_DIST);
+		moveNeighbours.pos = psDroid->pos.xy;
+		moveNeighbours.found = true;
+	}
+	if (iHypot(psDroid->pos.xy - moveNeighbours.pos) + radius > MOVE_NEIGHBOUR_DIST)
+	{
+		neighbours = gridStartIterate(psDroid->pos.x, psDroid->pos.y, radius);  // Moved too far, so the objects found might not cover the radius.
+		return;
+	}
+
+	neighbours.clear();
+	for (GridIterator gi = moveNeighbours.objects.begin(); gi != moveNeighbours.objects.end(); ++gi)
+	{
+		Vector2i diff = (*gi)->pos.xy - psDroid->pos.xy;
+		if ((uint32_t)(diff * diff) <= (uint32_t)(radius * radius))
+		{
+			neighbours.push_back(*gi);
+		}
+	}
+}
+
 const char *moveDescription(MOVE_STATUS status)
 {
 	switch (status)
@@ -279,7 +326,7 @@ static void moveShuffleDroid(DROID *psDroid, Vector2i s)
 
 	// find any droids that could block the shuffle
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(psDroid->pos.x, psDroid->pos.y, SHUFFLE_DIST);
+	moveGetNeighbours(psDroid, SHUFFLE_DIST, gridList);
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
 		DROID *psCurr = castDroid(*gi);
@@ -595,7 +642,7 @@ static void moveCheckSquished(DROID *psDroid, int32_t emx, int32_t emy)
 	const int32_t   my = gameTimeAdjustedAverage(emy, EXTRA_PRECISION);
 
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(psDroid->pos.x, psDroid->pos.y, OBJ_MAXRADIUS);
+	moveGetNeighbours(psDroid, OBJ_MAXRADIUS, gridList);
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
 		BASE_OBJECT *psObj = *gi;
@@ -1038,7 +1085,7 @@ static void moveCalcDroidSlide(DROID *psDroid, int *pmx, int *pmy)
 	droidR = moveObjRadius((BASE_OBJECT *)psDroid);
 	BASE_OBJECT *psObst = NULL;
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(psDroid->pos.x, psDroid->pos.y, OBJ_MAXRADIUS);
+	moveGetNeighbours(psDroid, OBJ_MAXRADIUS, gridList);
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
 		BASE_OBJECT *psObj = *gi;
@@ -1153,7 +1200,7 @@ static Vector2i moveGetObstacleVector(DROID *psDroid, Vector2i dest)
 
 	// scan the neighbours for obstacles
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(psDroid->pos.x, psDroid->pos.y, AVOID_DIST);
+	moveGetNeighbours(psDroid, AVOID_DIST, gridList);
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
 		if (*gi == psDroid)
@@ -1997,7 +2044,7 @@ static void checkLocalFeatures(DROID *psDroid)
 	// scan the neighbours
 #define DROIDDIST ((TILE_UNITS*5)/2)
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(psDroid->pos.x, psDroid->pos.y, DROIDDIST);
+	moveGetNeighbours(psDroid, DROIDDIST, gridList);
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
 		BASE_OBJECT *psObj = *gi;
@@ -2046,6 +2093,10 @@ void moveUpdateDroid(DROID *psDroid)
 
 	CHECK_DROID(psDroid);
 
+	// Other droids may have moved since the last update, so look for neighbours again.
+	moveNeighbours.psDroid = psDroid;
+	moveNeighbours.found = false;
+
 	psPropStats = asPropulsionStats + psDroid->asBits[COMP_PROPULSION];
 	ASSERT_OR_RETURN(, psPropStats != NULL, "Invalid propulsion stats pointer");
 
@@ -2260,7 +2311,7 @@ void moveUpdateDroid(DROID *psDroid)
 	if (map_coord(oldx) != map_coord(psDroid->pos.x)
 	    || map_coord(oldy) != map_coord(psDroid->pos.y))
 	{
-		visTilesUpdate((BASE_OBJECT *)psDroid);
+		visTilesUpdateLater(psDroid);
 
 		// object moved from one tile to next, check to see if droid is near stuff.(oil)
 		checkLocalFeatures(psDroid);
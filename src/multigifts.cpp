@@ -685,7 +685,7 @@ void recvMultiPlayerFeature(NETQUEUE queue)
 		{
 			// Create a feature of the specified type at the given location
 			FEATURE *result = buildFeature(&asFeatureStats[i], x, y, false);
-			result->id = id;
+			setObjectId(result, id);
 			break;
 		}
 	}
@@ -705,6 +705,7 @@ bool pickupArtefact(int toPlayer, int fromPlayer)
 				if (asResearch[topic].researchPower && asResearch[topic].researchPoints)
 				{
 					MakeResearchPossible(&asPlayerResList[toPlayer][topic]);
+					researchCandidatesChanged(toPlayer);
 					if (toPlayer == selectedPlayer)
 					{
 						CONPRINTF(ConsoleString, (ConsoleString, _("You Discover Blueprints For %s"), getName(&asResearch[topic])));
@@ -46,6 +46,7 @@
 
 #include "lib/gamelib/gtime.h"
 #include "lib/netplay/netplay.h"
+#include "lib/netplay/netreplay.h"
 #include "lib/script/script.h"
 #include "lib/widget/editbox.h"
 #include "lib/widget/button.h"
@@ -191,6 +192,9 @@ static void		addConsoleBox(void);
 static	void	disableMultiButs(void);
 static	void	processMultiopWidgets(UDWORD);
 static	void	SendFireUp(void);
+static void resetGameOptions();
+static bool hostGame();
+static void startSkirmishTest();
 
 static	void	decideWRF(void);
 
@@ -351,8 +355,9 @@ void loadMultiScripts()
 			NetPlay.players[i].ai = 0;  // For autogames.
 		}
 		// The i == selectedPlayer hack is to enable autogames
+		// When playing back a replay, the orders of the AIs are in the replay.
 		if (bMultiPlayer && game.type == SKIRMISH && (!NetPlay.players[i].allocated || i == selectedPlayer)
-		    && (NetPlay.players[i].ai >= 0 || hostlaunch == 2) && myResponsibility(i))
+		    && (NetPlay.players[i].ai >= 0 || hostlaunch == 2) && myResponsibility(i) && !NETisReplay())
 		{
 			if (PHYSFS_exists(ininame.toUtf8().constData())) // challenge file may override AI
 			{
@@ -389,7 +394,7 @@ void loadMultiScripts()
 	}
 
 	// Load scavengers
-	if (game.scavengers && myResponsibility(scavengerPlayer()))
+	if (game.scavengers && myResponsibility(scavengerPlayer()) && !NETisReplay())
 	{
 		debug(LOG_SAVE, "Loading scavenger AI for player %d", scavengerPlayer());
 		loadPlayerScript("multiplay/script/scavfact.js", scavengerPlayer(), DIFFICULTY_EASY);
@@ -3067,17 +3072,11 @@ static void processMultiopWidgets(UDWORD id)
 		sstrcpy(game.name, widgGetString(psWScreen, MULTIOP_GNAME));	// game name
 		sstrcpy(sPlayer, widgGetString(psWScreen, MULTIOP_PNAME));	// pname
 
-		resetReadyStatus(false);
-		resetDataHash();
-		removeWildcards((char *)sPlayer);
-
-		if (!hostCampaign((char *)game.name, (char *)sPlayer))
+		if (!hostGame())
 		{
 			addConsoleMessage(_("Sorry! Failed to host the game."), DEFAULT_JUSTIFY, SYSTEM_MESSAGE);
 			break;
 		}
-		bHosted = true;
-		loadMapSettings2();
 
 		widgDelete(psWScreen, MULTIOP_REFRESH);
 		widgDelete(psWScreen, MULTIOP_HOST);
@@ -3767,11 +3766,84 @@ static bool loadSettings(const QString &filename)
 	return true;
 }
 
-bool startMultiOptions(bool bReenter)
+/// Hosts and starts the --skirmish test game, for --headless, where there is no frontend to set it up in.
+/// Does what titleLoop(), startMultiOptions() and processMultiopWidgets(MULTIOP_HOST) do for an autogame, without the widgets.
+/// Resets the game options to their defaults, when setting up a new game.
+static void resetGameOptions()
+{
+	PLAYERSTATS nullStats;
+
+	memset(nameOverrides, 0, sizeof(nameOverrides));
+	memset(&locked, 0, sizeof(locked)); // nothing is locked by default
+	for (unsigned i = 0; i < MAX_PLAYERS; i++)
+	{
+		game.skDiff[i] = (DIFF_SLIDER_STOPS / 2);	// reset AI (turn it on again)
+		setPlayerColour(i, i);						//reset all colors as well
+	}
+	game.isMapMod = false;			// reset map-mod status
+	game.mapHasScavengers = true; // FIXME, should default to false
+	if (!NetPlay.bComms)			// force skirmish if no comms.
+	{
+		game.type = SKIRMISH;
+		sstrcpy(game.map, DEFAULTSKIRMISHMAP);
+		game.hash = levGetMapNameHash(game.map);
+		game.maxPlayers = 4;
+	}
+
+	ingame.localOptionsReceived = false;
+
+	loadMultiStats((char *)sPlayer, &nullStats);
+}
+
+/// Hosts the game named game.name, as sPlayer. Returns false if hosting failed.
+static bool hostGame()
+{
+	resetReadyStatus(false);
+	resetDataHash();
+	removeWildcards((char *)sPlayer);
+
+	if (!hostCampaign((char *)game.name, (char *)sPlayer))
+	{
+		return false;
+	}
+	bHosted = true;
+	loadMapSettings2();
+	return true;
+}
+
+/// Starts the --skirmish test game, once hosted.
+static void startSkirmishTest()
+{
+	loadSettings("tests/" + QString::fromStdString(wz_skirmish_test()));
+	startMultiplayerGame();
+	// reset flag in case people dropped/quit on join screen
+	NETsetPlayerConnectionStatus(CONNECTIONSTATUS_NORMAL, NET_ALL_PLAYERS);
+}
+
+bool startHeadlessSkirmish()
 {
-	PLAYERSTATS		nullStats;
-	UBYTE i;
+	ASSERT_OR_RETURN(false, hostlaunch == 2, "No skirmish test to start");
+
+	SPinit();
+	bMultiPlayer = true;
+	ingame.bHostSetup = true;
+	game.type = SKIRMISH;
+
+	resetGameOptions();
+	if (!hostGame())
+	{
+		debug(LOG_ERROR, "Failed to host the skirmish test.");
+		return false;
+	}
+	ingame.localOptionsReceived = true;
+
+	SendReadyRequest(selectedPlayer, true);
+	startSkirmishTest();
+	return true;
+}
 
+bool startMultiOptions(bool bReenter)
+{
 	netPlayersUpdated = true;
 
 	addBackdrop();
@@ -3796,32 +3868,12 @@ bool startMultiOptions(bool bReenter)
 
 	if (!bReenter)
 	{
-		memset(nameOverrides, 0, sizeof(nameOverrides));
-		memset(&locked, 0, sizeof(locked)); // nothing is locked by default
-
 		teamChooserUp = -1;
 		aiChooserUp = -1;
 		difficultyChooserUp = -1;
 		positionChooserUp = -1;
 		colourChooserUp = -1;
-		for (i = 0; i < MAX_PLAYERS; i++)
-		{
-			game.skDiff[i] = (DIFF_SLIDER_STOPS / 2);	// reset AI (turn it on again)
-			setPlayerColour(i, i);						//reset all colors as well
-		}
-		game.isMapMod = false;			// reset map-mod status
-		game.mapHasScavengers = true; // FIXME, should default to false
-		if (!NetPlay.bComms)			// force skirmish if no comms.
-		{
-			game.type = SKIRMISH;
-			sstrcpy(game.map, DEFAULTSKIRMISHMAP);
-			game.hash = levGetMapNameHash(game.map);
-			game.maxPlayers = 4;
-		}
-
-		ingame.localOptionsReceived = false;
-
-		loadMultiStats((char *)sPlayer, &nullStats);
+		resetGameOptions();
 	}
 	if (!bReenter && challengeActive)
 	{
@@ -3910,10 +3962,7 @@ bool startMultiOptions(bool bReenter)
 		SendReadyRequest(selectedPlayer, true);
 		if (hostlaunch == 2)
 		{
-			loadSettings("tests/" + QString::fromStdString(wz_skirmish_test()));
-			startMultiplayerGame();
-			// reset flag in case people dropped/quit on join screen
-			NETsetPlayerConnectionStatus(CONNECTIONSTATUS_NORMAL, NET_ALL_PLAYERS);
+			startSkirmishTest();
 		}
 	}
 
@@ -108,6 +108,7 @@ void updateLimitFlags(void);
 
 extern	void	runMultiOptions(void);
 extern	bool	startMultiOptions(bool bReenter);
+bool startHeadlessSkirmish();
 extern	void	frontendMultiMessages(void);
 
 bool addMultiBut(W_SCREEN *screen, UDWORD formid, UDWORD id, UDWORD x, UDWORD y, UDWORD width, UDWORD height, const char *tipres, UDWORD norm, UDWORD down, UDWORD hi, unsigned tc = MAX_PLAYERS);
@@ -304,86 +304,32 @@ bool multiPlayerLoop(void)
 // to get droids ...
 DROID *IdToDroid(UDWORD id, UDWORD player)
 {
-	if (player == ANYPLAYER)
+	if (player != ANYPLAYER && player >= MAX_PLAYERS)
 	{
-		for (int i = 0; i < MAX_PLAYERS; i++)
-		{
-			for (DROID *d = apsDroidLists[i]; d; d = d->psNext)
-			{
-				if (d->id == id)
-				{
-					return d;
-				}
-			}
-		}
-	}
-	else if (player < MAX_PLAYERS)
-	{
-		for (DROID *d = apsDroidLists[player]; d; d = d->psNext)
-		{
-			if (d->id == id)
-			{
-				return d;
-			}
-		}
+		return NULL;
 	}
-	return NULL;
+	return castDroid(findObjectById(id, OBJ_DROID, OBJLIST_CURRENT, player == ANYPLAYER ? -1 : player));
 }
 
 // find off-world droids
 DROID *IdToMissionDroid(UDWORD id, UDWORD player)
 {
-	if (player == ANYPLAYER)
-	{
-		for (int i = 0; i < MAX_PLAYERS; i++)
-		{
-			for (DROID *d = mission.apsDroidLists[i]; d; d = d->psNext)
-			{
-				if (d->id == id)
-				{
-					return d;
-				}
-			}
-		}
-	}
-	else if (player < MAX_PLAYERS)
+	if (player != ANYPLAYER && player >= MAX_PLAYERS)
 	{
-		for (DROID *d = mission.apsDroidLists[player]; d; d = d->psNext)
-		{
-			if (d->id == id)
-			{
-				return d;
-			}
-		}
+		return NULL;
 	}
-	return NULL;
+	return castDroid(findObjectById(id, OBJ_DROID, OBJLIST_MISSION, player == ANYPLAYER ? -1 : player));
 }
 
 // ////////////////////////////////////////////////////////////////////////////
 // find a structure
 STRUCTURE *IdToStruct(UDWORD id, UDWORD player)
 {
-	int beginPlayer = 0, endPlayer = MAX_PLAYERS;
-	if (player != ANYPLAYER)
+	if (player != ANYPLAYER && player >= MAX_PLAYERS)
 	{
-		beginPlayer = player;
-		endPlayer = std::min<int>(player + 1, MAX_PLAYERS);
-	}
-	STRUCTURE **lists[2] = {apsStructLists, mission.apsStructLists};
-	for (int j = 0; j < 2; ++j)
-	{
-		for (int i = beginPlayer; i < endPlayer; ++i)
-		{
-			for (STRUCTURE *d = lists[j][i]; d; d = d->psNext)
-			{
-				if (d->id == id)
-				{
-					return d;
-				}
-			}
-		}
+		return NULL;
 	}
-	return NULL;
+	return castStructure(findObjectById(id, OBJ_STRUCTURE, OBJLIST_CURRENT | OBJLIST_MISSION, player == ANYPLAYER ? -1 : player));
 }
 
 // ////////////////////////////////////////////////////////////////////////////
@@ -391,14 +337,7 @@ STRUCTURE *IdToStruct(UDWORD id, UDWORD player)
 FEATURE *IdToFeature(UDWORD id, UDWORD player)
 {
 	(void)player;	// unused, all features go into player 0
-	for (FEATURE *d = apsFeatureLists[0]; d; d = d->psNext)
-	{
-		if (d->id == id)
-		{
-			return d;
-		}
-	}
-	return NULL;
+	return castFeature(findObjectById(id, OBJ_FEATURE, OBJLIST_CURRENT));
 }
 
 // ////////////////////////////////////////////////////////////////////////////
@@ -106,7 +106,6 @@ bool recvBuildFinished(NETQUEUE queue)
 		if (psStruct->status != SS_BUILT)
 		{
 			debug(LOG_SYNC, "Synch error, structure %u was not complete, and should have been.", structId);
-			psStruct->status = SS_BUILT;
 			buildingComplete(psStruct);
 		}
 		debug(LOG_SYNC, "Created normal building %u for player %u", psStruct->id, player);
@@ -126,8 +125,7 @@ bool recvBuildFinished(NETQUEUE queue)
 		if (asStructureStats[typeindex].type == psStruct->pStructureType->type)
 		{
 			// Correct type, correct location, just rename the id's to sync it.. (urgh)
-			psStruct->id = structId;
-			psStruct->status = SS_BUILT;
+			setObjectId(psStruct, structId);
 			buildingComplete(psStruct);
 			debug(LOG_SYNC, "Created modified building %u for player %u", psStruct->id, player);
 #if defined (DEBUG)
@@ -141,8 +139,7 @@ bool recvBuildFinished(NETQUEUE queue)
 
 	if (psStruct)
 	{
-		psStruct->id		= structId;
-		psStruct->status	= SS_BUILT;
+		setObjectId(psStruct, structId);
 		buildingComplete(psStruct);
 		debug(LOG_SYNC, "Huge synch error, forced to create building %u for player %u", psStruct->id, player);
 #if defined (DEBUG)
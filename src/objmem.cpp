@@ -24,8 +24,10 @@
  *
  */
 #include <string.h>
+#include <unordered_map>
 
 #include "lib/framework/frame.h"
+#include "lib/framework/wzpool.h"
 #include "objects.h"
 #include "lib/gamelib/gtime.h"
 #include "lib/netplay/netplay.h"
@@ -69,6 +71,30 @@ FLAG_POSITION	*apsFlagPosLists[MAX_PLAYERS];
 /* The list of destroyed objects */
 BASE_OBJECT		*psDestroyedObj = NULL;
 
+/// Lists of objects in objIdIndex, in the order getBaseObjFromId searched them.
+enum OBJ_INDEX_LIST
+{
+	OBJ_INDEX_DROIDS, OBJ_INDEX_STRUCTS, OBJ_INDEX_FEATURES,
+	OBJ_INDEX_MISSION_DROIDS, OBJ_INDEX_MISSION_STRUCTS, OBJ_INDEX_MISSION_FEATURES,
+	OBJ_INDEX_LIMBO_DROIDS,
+	OBJ_INDEX_LISTS
+};
+
+struct OBJ_INDEX_ENTRY
+{
+	BASE_OBJECT *psObj;
+	uint8_t     list;                   ///< OBJ_INDEX_LIST the object is in.
+	uint8_t     player;                 ///< Which of the players' lists the object is in.
+};
+
+/// Objects in the droid, structure, feature, mission and limbo lists, by id, so that they can be found without walking the lists.
+static std::unordered_map<uint32_t, OBJ_INDEX_ENTRY> objIdIndex;
+/// Heads of the lists when objIdIndex was last updated. If the lists were changed without going through this file, such as when swapping the mission lists, the heads change and the index is regenerated.
+static BASE_OBJECT *objIndexHeads[OBJ_INDEX_LISTS][MAX_PLAYERS];
+static bool objIndexValid = false;
+/// Whether some id is used by more than one object. Then any change regenerates objIdIndex, so that the same object is found as when walking the lists.
+static bool objIndexDuplicates = false;
+
 /* Forward function declarations */
 #ifdef DEBUG
 static void objListIntegCheck(void);
@@ -88,6 +114,82 @@ bool objmemInitialise(void)
 /* Release the object heaps */
 void objmemShutdown(void)
 {
+	objIdIndex.clear();
+	objIndexValid = false;
+	WzPool::logStats();
+}
+
+/// Returns the head of a list in objIdIndex, or NULL if the lookup functions never searched that list.
+static BASE_OBJECT *objIndexHead(unsigned list, unsigned player)
+{
+	switch (list)
+	{
+	case OBJ_INDEX_DROIDS:           return apsDroidLists[player];
+	case OBJ_INDEX_STRUCTS:          return apsStructLists[player];
+	case OBJ_INDEX_FEATURES:         return player == 0 ? apsFeatureLists[0] : NULL;
+	case OBJ_INDEX_MISSION_DROIDS:   return mission.apsDroidLists[player];
+	case OBJ_INDEX_MISSION_STRUCTS:  return mission.apsStructLists[player];
+	case OBJ_INDEX_MISSION_FEATURES: return player == 0 ? mission.apsFeatureLists[0] : NULL;
+	case OBJ_INDEX_LIMBO_DROIDS:     return player == 0 ? apsLimboDroids[0] : NULL;
+	default:                         return NULL;
+	}
+}
+
+/// Returns which OBJ_INDEX_LIST the list is, or OBJ_INDEX_LISTS if it's not in objIdIndex.
+template <typename OBJECT>
+static unsigned objIndexList(OBJECT *list[], int player)
+{
+	void *lists[OBJ_INDEX_LISTS] = {apsDroidLists, apsStructLists, apsFeatureLists, mission.apsDroidLists, mission.apsStructLists, mission.apsFeatureLists, apsLimboDroids};
+	for (unsigned l = 0; l < OBJ_INDEX_LISTS; ++l)
+	{
+		if ((void *)list == lists[l])
+		{
+			if ((l == OBJ_INDEX_FEATURES || l == OBJ_INDEX_MISSION_FEATURES || l == OBJ_INDEX_LIMBO_DROIDS) && player != 0)
+			{
+				return OBJ_INDEX_LISTS;
+			}
+			return l;
+		}
+	}
+	return OBJ_INDEX_LISTS;
+}
+
+/// Regenerates objIdIndex, if the lists changed behind its back.
+static void objIndexCheck()
+{
+	if (objIndexValid)
+	{
+		for (unsigned list = 0; list < OBJ_INDEX_LISTS; ++list)
+		{
+			for (unsigned player = 0; player < MAX_PLAYERS; ++player)
+			{
+				objIndexValid = objIndexValid && objIndexHeads[list][player] == objIndexHead(list, player);
+			}
+		}
+		if (objIndexValid)
+		{
+			return;
+		}
+	}
+
+	objIdIndex.clear();
+	objIndexDuplicates = false;
+	for (unsigned list = 0; list < OBJ_INDEX_LISTS; ++list)
+	{
+		for (unsigned player = 0; player < MAX_PLAYERS; ++player)
+		{
+			objIndexHeads[list][player] = objIndexHead(list, player);
+			for (BASE_OBJECT *psObj = objIndexHeads[list][player]; psObj != NULL; psObj = psObj->psNext)
+			{
+				OBJ_INDEX_ENTRY entry = {psObj, (uint8_t)list, (uint8_t)player};
+				if (!objIdIndex.insert(std::make_pair(psObj->id, entry)).second)
+				{
+					objIndexDuplicates = true;  // Didn't replace, so the same object is found as when walking the lists.
+				}
+			}
+		}
+	}
+	objIndexValid = true;
 }
 
 // Check that psVictim is not referred to by any other object in the game. We can dump out some extra data in debug builds that help track down sources of dangling pointer errors.
@@ -253,9 +355,44 @@ static inline void addObjectToList(OBJECT *list[], OBJECT *object, int player)
 {
 	ASSERT_OR_RETURN(, object != NULL, "Invalid pointer");
 
+	objIndexCheck();
+
 	// Prepend the object to the top of the list
 	object->psNext = list[player];
 	list[player] = object;
+
+	unsigned indexList = objIndexList(list, player);
+	if (indexList != OBJ_INDEX_LISTS)
+	{
+		auto i = objIdIndex.find(object->id);
+		if (objIndexDuplicates || (i != objIdIndex.end() && i->second.psObj != object))
+		{
+			objIndexValid = false;  // Duplicated id, so regenerate the index in list order, rather than guessing which object comes first.
+			return;
+		}
+		OBJ_INDEX_ENTRY entry = {object, (uint8_t)indexList, (uint8_t)player};
+		objIdIndex[object->id] = entry;
+		objIndexHeads[indexList][player] = object;
+	}
+}
+
+/* Forget the object, after removing it from the list
+ * \param list is a pointer to the object list
+ */
+template <typename OBJECT>
+static inline void objIndexRemove(OBJECT *list[], OBJECT *object, int player)
+{
+	unsigned indexList = objIndexList(list, player);
+	if (indexList != OBJ_INDEX_LISTS)
+	{
+		auto i = objIdIndex.find(object->id);
+		if (i != objIdIndex.end() && i->second.psObj == object)
+		{
+			objIdIndex.erase(i);
+		}
+		objIndexHeads[indexList][player] = list[player];
+		objIndexValid = objIndexValid && !objIndexDuplicates;  // Removing a duplicated id may uncover another object with it.
+	}
 }
 
 /* Add the object to its list
@@ -282,10 +419,13 @@ static inline void destroyObject(OBJECT *list[], OBJECT *object)
 	ASSERT_OR_RETURN(, object != NULL, "Invalid pointer");
 	ASSERT(gameTime - deltaGameTime <= gameTime || gameTime == 2, "Expected %u <= %u, bad time", gameTime - deltaGameTime, gameTime);
 
+	objIndexCheck();
+
 	// If the message to remove is the first one in the list then mark the next one as the first
 	if (list[object->player] == object)
 	{
 		list[object->player] = list[object->player]->psNext;
+		objIndexRemove(list, object, object->player);
 		object->psNext = psDestroyedObj;
 		psDestroyedObj = (BASE_OBJECT *)object;
 		object->died = gameTime;
@@ -307,6 +447,7 @@ static inline void destroyObject(OBJECT *list[], OBJECT *object)
 		// Modify the "next" pointer of the previous item to
 		// point to the "next" item of the item to delete.
 		psPrev->psNext = psCurr->psNext;
+		objIndexRemove(list, object, object->player);
 
 		// Prepend the object to the destruction list
 		object->psNext = psDestroyedObj;
@@ -328,10 +469,13 @@ static inline void removeObjectFromList(OBJECT *list[], OBJECT *object, int play
 {
 	ASSERT_OR_RETURN(, object != NULL, "Invalid pointer");
 
+	objIndexCheck();
+
 	// If the message to remove is the first one in the list then mark the next one as the first
 	if (list[player] == object)
 	{
 		list[player] = list[player]->psNext;
+		objIndexRemove(list, object, player);
 		return;
 	}
 
@@ -347,6 +491,7 @@ static inline void removeObjectFromList(OBJECT *list[], OBJECT *object, int play
 	// Modify the "next" pointer of the previous item to
 	// point to the "next" item of the item to delete.
 	psPrev->psNext = psCurr->psNext;
+	objIndexRemove(list, object, player);
 }
 
 /* Remove an object from the relevant function list. An object can only be in one function list at a time!
@@ -402,6 +547,7 @@ static inline void releaseAllObjectsInList(OBJECT *list[])
 		}
 		list[i] = NULL;
 	}
+	objIndexValid = false;  // The objects are gone, so don't even look at them when checking the index.
 }
 
 /***************************************************************************************
@@ -768,153 +914,106 @@ void checkFactoryFlags(void)
 
 /**************************  OBJECT ACCESS FUNCTIONALITY ********************************/
 
-// Find a base object from it's id
-BASE_OBJECT *getBaseObjFromData(unsigned id, unsigned player, OBJECT_TYPE type)
+BASE_OBJECT *findObjectById(uint32_t id, OBJECT_TYPE type, unsigned lists, int player)
 {
-	BASE_OBJECT		*psObj;
-	DROID			*psTrans;
+	objIndexCheck();
 
-	for (int i = 0; i < 3; ++i)
+	auto i = objIdIndex.find(id);
+	if (i == objIdIndex.end())
 	{
-		psObj = NULL;
-		switch (i)
+		return NULL;
+	}
+	OBJ_INDEX_ENTRY const &entry = i->second;
+	const unsigned listFlag = entry.list == OBJ_INDEX_LIMBO_DROIDS ? OBJLIST_LIMBO : entry.list >= OBJ_INDEX_MISSION_DROIDS ? OBJLIST_MISSION : OBJLIST_CURRENT;
+	if ((type != OBJ_NUM_TYPES && entry.psObj->type != type) || (lists & listFlag) == 0
+	    || (player >= 0 && entry.psObj->type != OBJ_FEATURE && entry.player != player))
+	{
+		return NULL;
+	}
+	return entry.psObj;
+}
+
+/// Finds a droid inside a transporter. Walks the lists, so only use if findObjectById didn't find anything.
+static DROID *findTransportedDroid(uint32_t id, unsigned lists, int player)
+{
+	for (unsigned list = OBJ_INDEX_DROIDS; list < OBJ_INDEX_LISTS; list += OBJ_INDEX_MISSION_DROIDS - OBJ_INDEX_DROIDS)
+	{
+		const unsigned listFlag = list == OBJ_INDEX_LIMBO_DROIDS ? OBJLIST_LIMBO : list == OBJ_INDEX_MISSION_DROIDS ? OBJLIST_MISSION : OBJLIST_CURRENT;
+		if ((lists & listFlag) == 0)
 		{
-		case 0:
-			switch (type)
-			{
-			case OBJ_DROID: psObj = apsDroidLists[player]; break;
-			case OBJ_STRUCTURE: psObj = apsStructLists[player]; break;
-			case OBJ_FEATURE: psObj = apsFeatureLists[0];
-			default: break;
-			}
-			break;
-		case 1:
-			switch (type)
-			{
-			case OBJ_DROID: psObj = mission.apsDroidLists[player]; break;
-			case OBJ_STRUCTURE: psObj = mission.apsStructLists[player]; break;
-			case OBJ_FEATURE: psObj = mission.apsFeatureLists[0]; break;
-			default: break;
-			}
-			break;
-		case 2:
-			if (player == 0 && type == OBJ_DROID)
-			{
-				psObj = apsLimboDroids[0];
-			}
-			break;
+			continue;
 		}
-
-		while (psObj)
+		for (int p = 0; p < MAX_PLAYERS; ++p)
 		{
-			if (psObj->id == id)
+			if (player >= 0 && p != player)
 			{
-				return psObj;
+				continue;
 			}
-			// if transporter check any droids in the grp
-			if ((psObj->type == OBJ_DROID) && isTransporter((DROID *)psObj))
+			for (DROID *psDroid = castDroid(objIndexHead(list, p)); psDroid != NULL; psDroid = psDroid->psNext)
 			{
-				for (psTrans = ((DROID *)psObj)->psGroup->psList; psTrans != NULL; psTrans = psTrans->psGrpNext)
+				if (!isTransporter(psDroid))
+				{
+					continue;
+				}
+				for (DROID *psTrans = psDroid->psGroup->psList; psTrans != NULL; psTrans = psTrans->psGrpNext)
 				{
 					if (psTrans->id == id)
 					{
-						return (BASE_OBJECT *)psTrans;
+						return psTrans;
 					}
 				}
 			}
-			psObj = psObj->psNext;
 		}
 	}
-	ASSERT(false, "failed to find id %d for player %d", id, player);
-
 	return NULL;
 }
 
+// Find a base object from it's id
+BASE_OBJECT *getBaseObjFromData(unsigned id, unsigned player, OBJECT_TYPE type)
+{
+	// The limbo list was only ever searched for player 0.
+	const unsigned lists = OBJLIST_CURRENT | OBJLIST_MISSION | (player == 0 && type == OBJ_DROID ? OBJLIST_LIMBO : 0);
+	BASE_OBJECT *psObj = findObjectById(id, type, lists, player);
+	if (psObj == NULL && type == OBJ_DROID)
+	{
+		psObj = findTransportedDroid(id, lists, player);
+	}
+	ASSERT(psObj != NULL, "failed to find id %d for player %d", id, player);
+
+	return psObj;
+}
+
 // Find a base object from it's id
 BASE_OBJECT *getBaseObjFromId(UDWORD id)
 {
-	unsigned int i;
-	UDWORD			player;
-	BASE_OBJECT		*psObj;
-	DROID			*psTrans;
+	BASE_OBJECT *psObj = findObjectById(id, OBJ_NUM_TYPES, OBJLIST_ALL);
+	if (psObj == NULL)
+	{
+		psObj = findTransportedDroid(id, OBJLIST_ALL, -1);
+	}
+	ASSERT(psObj != NULL, "getBaseObjFromId() failed for id %d", id);
+
+	return psObj;
+}
 
-	for (i = 0; i < 7; ++i)
+void setObjectId(BASE_OBJECT *psObj, uint32_t id)
+{
+	auto i = objIdIndex.find(psObj->id);
+	if (i != objIdIndex.end() && i->second.psObj == psObj)
 	{
-		for (player = 0; player < MAX_PLAYERS; ++player)
+		OBJ_INDEX_ENTRY entry = i->second;
+		objIdIndex.erase(i);
+		auto j = objIdIndex.find(id);
+		if (objIndexDuplicates || (j != objIdIndex.end() && j->second.psObj != psObj))
 		{
-			switch (i)
-			{
-			case 0:
-				psObj = (BASE_OBJECT *)apsDroidLists[player];
-				break;
-			case 1:
-				psObj = (BASE_OBJECT *)apsStructLists[player];
-				break;
-			case 2:
-				if (player == 0)
-				{
-					psObj = (BASE_OBJECT *)apsFeatureLists[0];
-				}
-				else
-				{
-					psObj = NULL;
-				}
-				break;
-			case 3:
-				psObj = (BASE_OBJECT *)mission.apsDroidLists[player];
-				break;
-			case 4:
-				psObj = (BASE_OBJECT *)mission.apsStructLists[player];
-				break;
-			case 5:
-				if (player == 0)
-				{
-					psObj = (BASE_OBJECT *)mission.apsFeatureLists[0];
-				}
-				else
-				{
-					psObj = NULL;
-				}
-				break;
-			case 6:
-				if (player == 0)
-				{
-					psObj = (BASE_OBJECT *)apsLimboDroids[0];
-				}
-				else
-				{
-					psObj = NULL;
-				}
-				break;
-			default:
-				psObj = NULL;
-				break;
-			}
-
-			while (psObj)
-			{
-				if (psObj->id == id)
-				{
-					return psObj;
-				}
-				// if transporter check any droids in the grp
-				if ((psObj->type == OBJ_DROID) && isTransporter((DROID *)psObj))
-				{
-					for (psTrans = ((DROID *)psObj)->psGroup->psList; psTrans != NULL; psTrans = psTrans->psGrpNext)
-					{
-						if (psTrans->id == id)
-						{
-							return (BASE_OBJECT *)psTrans;
-						}
-					}
-				}
-				psObj = psObj->psNext;
-			}
+			objIndexValid = false;  // Duplicated id, so regenerate the index in list order.
+		}
+		else
+		{
+			objIdIndex[id] = entry;
 		}
 	}
-	ASSERT(!"couldn't find a BASE_OBJ with ID", "getBaseObjFromId() failed for id %d", id);
-
-	return NULL;
+	psObj->id = id;
 }
 
 UDWORD getRepairIdFromFlag(FLAG_POSITION *psFlag)
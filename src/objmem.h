@@ -102,6 +102,23 @@ extern void removeFlagPosition(FLAG_POSITION *psDel);
 extern void freeAllFlagPositions(void);
 extern void freeAllAssemblyPoints(void);
 
+/// Object lists which findObjectById can search.
+enum OBJECT_LISTS
+{
+	OBJLIST_CURRENT = 1,  ///< apsDroidLists, apsStructLists and apsFeatureLists.
+	OBJLIST_MISSION = 2,  ///< The lists in mission, of the map not being played on.
+	OBJLIST_LIMBO   = 4,  ///< apsLimboDroids[0].
+	OBJLIST_ALL     = 7,
+};
+
+/** Finds an object by id, without walking the object lists. Returns NULL if not found.
+ *  Type can be OBJ_NUM_TYPES to find any type of object, lists is a combination of OBJECT_LISTS, and if player isn't -1, only that player's lists are searched.
+ *  Droids inside transporters aren't in any list, so aren't found.
+ */
+BASE_OBJECT *findObjectById(uint32_t id, OBJECT_TYPE type, unsigned lists, int player = -1);
+/// Changes the id of an object, which may already be in a list.
+void setObjectId(BASE_OBJECT *psObj, uint32_t id);
+
 // Find a base object from it's id
 extern BASE_OBJECT *getBaseObjFromData(unsigned id, unsigned player, OBJECT_TYPE type);
 extern BASE_OBJECT *getBaseObjFromId(UDWORD id);
@@ -80,11 +80,13 @@ static uint64_t interleave(int32_t x, int32_t y)
 void PointTree::insert(void *pointData, int32_t x, int32_t y)
 {
 	points.push_back(Point(interleave(x, y), pointData));
+	++generation;
 }
 
 void PointTree::clear()
 {
 	points.clear();
+	++generation;
 }
 
 static bool pointTreeSortFunction(std::pair<uint64_t, void *> const &a, std::pair<uint64_t, void *> const &b)
@@ -95,6 +97,54 @@ static bool pointTreeSortFunction(std::pair<uint64_t, void *> const &a, std::pai
 void PointTree::sort()
 {
 	std::stable_sort(points.begin(), points.end(), pointTreeSortFunction);  // Stable sort to avoid unspecified behaviour when two objects are in exactly the same place.
+	++generation;
+}
+
+void PointTree::erase(std::function<bool (void *pointData)> const &shouldErase)
+{
+	points.erase(std::remove_if(points.begin(), points.end(), [&](Point const &point) {
+		return shouldErase(point.second);
+	}), points.end());
+	++generation;
+}
+
+void PointTree::move(std::function<Vector2i (void *pointData)> const &position)
+{
+	for (Vector::iterator i = points.begin(); i != points.end(); ++i)
+	{
+		Vector2i pos = position(i->second);
+		i->first = interleave(pos.x, pos.y);
+	}
+	++generation;
+
+	// Insertion sort, since most points will still be in the right place, or close to it. Gives the same result as
+	// sort(), since it is also stable. If too much needs moving, give up and use sort() for the rest.
+	size_t budget = points.size() * 8;
+	for (size_t i = 1; i < points.size(); ++i)
+	{
+		Point point = points[i];
+		size_t j = i;
+		for (; j > 0 && pointTreeSortFunction(point, points[j - 1]); --j)
+		{
+			points[j] = points[j - 1];
+		}
+		points[j] = point;
+
+		if (i - j >= budget)
+		{
+			sort();
+			return;
+		}
+		budget -= i - j;
+	}
+}
+
+void PointTree::merge(PointTree const &a, PointTree const &b)
+{
+	ASSERT_OR_RETURN(, this != &a && this != &b, "Can't merge into one of the sources");
+	points.resize(a.points.size() + b.points.size());
+	std::merge(a.points.begin(), a.points.end(), b.points.begin(), b.points.end(), points.begin(), pointTreeSortFunction);  // Stable, takes points from a first.
+	++generation;
 }
 
 //#define DUMP_IMAGE  // All x and y coordinates must be in range -500 to 499, if dumping an image.
@@ -128,8 +178,8 @@ static unsigned current(std::vector<unsigned> &filterData, unsigned i)
 	return ret;
 }
 
-template<bool IsFiltered>
-PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t minXo, int32_t minYo, int32_t maxXo, int32_t maxYo)
+template<bool IsFiltered, class Found>
+void PointTree::queryMaybeFilter(Filter &filter, int32_t minXo, int32_t minYo, int32_t maxXo, int32_t maxYo, Found const &found) const
 {
 	uint64_t minX = expandX(minXo);
 	uint64_t maxX = expandX(maxXo);
@@ -225,11 +275,6 @@ PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t min
 		--numRanges;
 	}
 
-	lastQueryResults.clear();
-	if (IsFiltered)
-	{
-		lastFilteredQueryIndices.clear();
-	}
 	for (int r = 0; r != numRanges; ++r)
 	{
 		// Find range of points which may be close enough. Range is [i1 ... i2 - 1]. The pointers are ignored when searching.
@@ -242,11 +287,7 @@ PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t min
 			uint64_t py = points[i].first & 0x5555555555555555ULL;
 			if (px >= minX && px <= maxX && py >= minY && py <= maxY)  // Only add point if it's at least in the desired square.
 			{
-				lastQueryResults.push_back(points[i].second);
-				if (IsFiltered)
-				{
-					lastFilteredQueryIndices.push_back(i);
-				}
+				found(points[i].second, i);
 #ifdef DUMP_IMAGE
 				if (doDump)
 				{
@@ -266,31 +307,61 @@ PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t min
 		fclose(f);
 	}
 #endif //DUMP_IMAGE
-
-	return lastQueryResults;
 }
 
-PointTree::ResultVector &PointTree::query(int32_t x, int32_t y, uint32_t x2, uint32_t y2)
+/// Stores query results in a ResultVector.
+struct PointTreeFoundResult
+{
+	PointTreeFoundResult(PointTree::ResultVector &results_) : results(results_) {}
+	void operator ()(void *pointData, unsigned) const
+	{
+		results.push_back(pointData);
+	}
+	PointTree::ResultVector &results;
+};
+
+/// Stores query results in a ResultVector, and their indices in an IndexVector.
+struct PointTreeFoundFilteredResult
+{
+	PointTreeFoundFilteredResult(PointTree::ResultVector &results_, PointTree::IndexVector &indices_) : results(results_), indices(indices_) {}
+	void operator ()(void *pointData, unsigned index) const
+	{
+		results.push_back(pointData);
+		indices.push_back(index);
+	}
+	PointTree::ResultVector &results;
+	PointTree::IndexVector &indices;
+};
+
+void PointTree::query(ResultVector &results, int32_t x, int32_t y, int32_t x2, int32_t y2) const
 {
 	Filter unused;
-	return queryMaybeFilter<false>(unused, x, y, x2, y2);
+	results.clear();
+	queryMaybeFilter<false>(unused, x, y, x2, y2, PointTreeFoundResult(results));
 }
 
-PointTree::ResultVector &PointTree::query(int32_t x, int32_t y, uint32_t radius)
+void PointTree::query(ResultVector &results, int32_t x, int32_t y, uint32_t radius) const
 {
 	Filter unused;
 	int32_t minXo = x - radius;
 	int32_t maxXo = x + radius;
 	int32_t minYo = y - radius;
 	int32_t maxYo = y + radius;
-	return queryMaybeFilter<false>(unused, minXo, minYo, maxXo, maxYo);
+	results.clear();
+	queryMaybeFilter<false>(unused, minXo, minYo, maxXo, maxYo, PointTreeFoundResult(results));
 }
 
-PointTree::ResultVector &PointTree::query(Filter &filter, int32_t x, int32_t y, uint32_t radius)
+void PointTree::query(ResultVector &results, IndexVector &indices, Filter &filter, int32_t x, int32_t y, uint32_t radius) const
 {
 	int32_t minXo = x - radius;
 	int32_t maxXo = x + radius;
 	int32_t minYo = y - radius;
 	int32_t maxYo = y + radius;
-	return queryMaybeFilter<true>(filter, minXo, minYo, maxXo, maxYo);
+	if (filter.generation != generation)
+	{
+		filter.reset(*this);
+	}
+	results.clear();
+	indices.clear();
+	queryMaybeFilter<true>(filter, minXo, minYo, maxXo, maxYo, PointTreeFoundFilteredResult(results, indices));
 }
@@ -21,7 +21,9 @@
 #define _point_tree_h
 
 #include "lib/framework/types.h"
+#include "lib/framework/vector.h"
 
+#include <functional>
 #include <vector>
 
 class PointTree
@@ -29,14 +31,15 @@ class PointTree
 public:
 	typedef std::vector<void *> ResultVector;
 	typedef std::vector<unsigned> IndexVector;
-	class Filter  ///< Filters are invalidated when modifying the PointTree.
+	class Filter  ///< Filters are reset by the next query, after modifying the PointTree.
 	{
 	public:
-		Filter() : data(1) {}  ///< Must be reset before use.
-		Filter(PointTree const &pointTree) : data(pointTree.points.size() + 1) {}
+		Filter() : data(1), generation(0) {}
+		Filter(PointTree const &pointTree) : data(pointTree.points.size() + 1), generation(pointTree.generation) {}
 		void reset(PointTree const &pointTree)
 		{
 			data.assign(pointTree.points.size() + 1, 0);
+			generation = pointTree.generation;
 		}
 		void erase(unsigned index)
 		{
@@ -49,33 +52,47 @@ public:
 		typedef std::vector<unsigned> Data;
 
 		Data data;
+		unsigned generation;  ///< PointTree::generation when last reset.
 	};
 
+	PointTree() : generation(1) {}
+
 	void insert(void *pointData, int32_t x, int32_t y);                       ///< Inserts a point into the point tree.
 	void clear();                                                             ///< Clears the PointTree.
 	void sort();                                                              ///< Must be done between inserting and querying, to get meaningful results.
-	/// Returns all points less than or equal to radius from (x, y), possibly plus some extra nearby points.
-	/// (More specifically, returns all objects in a square with edge length 2*radius.)
-	/// Note: Not thread safe, because it modifies lastQueryResults.
-	ResultVector &query(int32_t x, int32_t y, uint32_t radius);
-	/// Returns all points which have not been filtered away, less than or equal to radius from (x, y), possibly plus some extra nearby points.
-	/// (More specifically, returns objects in a square with edge length 2*radius.)
-	/// Note: Not thread safe, because it modifies lastQueryResults, lastFilteredQueryIndices and the internal filter representation for faster lookups.
-	ResultVector &query(Filter &filter, int32_t x, int32_t y, uint32_t radius);
-	/// Returns all points which have not been filtered away within given rectangle. See function above on thread safety.
-	ResultVector &query(int32_t x, int32_t y, uint32_t x2, uint32_t y2);
-
-	ResultVector lastQueryResults;
-	IndexVector lastFilteredQueryIndices;
+	/// Removes the points for which shouldErase(pointData) is true. The remaining points stay sorted.
+	void erase(std::function<bool (void *pointData)> const &shouldErase);
+	/// Moves all points to position(pointData), and sorts them again. Much faster than clear(), insert() and sort(), if the points have only moved a little since they were sorted.
+	void move(std::function<Vector2i (void *pointData)> const &position);
+	/// Replaces the points with the points of a and b, which must both be sorted. Where a and b have points in the same place, the points of a come first.
+	void merge(PointTree const &a, PointTree const &b);
+	bool empty() const                                                        ///< Whether there are no points.
+	{
+		return points.empty();
+	}
+
+	// The queries only write to the given results and filter, so several threads can query at once, as long as each
+	// has its own results and filters, and the PointTree isn't modified meanwhile.
+
+	/// Writes all points less than or equal to radius from (x, y), possibly plus some extra nearby points, to results.
+	/// (More specifically, finds all objects in a square with edge length 2*radius.)
+	void query(ResultVector &results, int32_t x, int32_t y, uint32_t radius) const;
+	/// Writes all points which have not been filtered away, less than or equal to radius from (x, y), possibly plus some extra nearby points, to results.
+	/// (More specifically, finds objects in a square with edge length 2*radius.)
+	/// The index of each point is written to indices, for Filter::erase. Also modifies the internal filter representation for faster lookups.
+	void query(ResultVector &results, IndexVector &indices, Filter &filter, int32_t x, int32_t y, uint32_t radius) const;
+	/// Writes all points within given rectangle to results.
+	void query(ResultVector &results, int32_t x, int32_t y, int32_t x2, int32_t y2) const;
 
 private:
 	typedef std::pair<uint64_t, void *> Point;
 	typedef std::vector<Point> Vector;
 
-	template<bool IsFiltered>
-	ResultVector &queryMaybeFilter(Filter &filter, int32_t minXo, int32_t maxXo, int32_t minYo, int32_t maxYo);
+	template<bool IsFiltered, class Found>
+	void queryMaybeFilter(Filter &filter, int32_t minXo, int32_t maxXo, int32_t minYo, int32_t maxYo, Found const &found) const;
 
 	Vector points;
+	unsigned generation;  ///< Changed whenever the points are, so that filters know to reset.
 };
 
 #endif //_point_tree_h
@@ -27,6 +27,8 @@
 
 #include "lib/framework/frame.h"
 #include "lib/framework/trig.h"
+#include "lib/framework/wzparallel.h"
+#include "lib/framework/wzpool.h"
 #include "lib/gamelib/gtime.h"
 #include "lib/sound/audio_id.h"
 #include "lib/sound/audio.h"
@@ -72,7 +74,7 @@ struct INTERVAL
 };
 
 // Watermelon:they are from droid.c
-/* The range for neighbouring objects */
+/* How far off the map objects can still be hit */
 #define PROJ_NEIGHBOUR_RANGE (TILE_UNITS*4)
 // used to create a specific ID for projectile objects to facilitate tracking them.
 static const UDWORD ProjectileTrackerID =	0xdead0000;
@@ -105,6 +107,30 @@ struct ObjectShape
 	Vector2i size;           ///< x == y if circular.
 };
 
+/// Where an object was at the start and end of the tick, and how big it is, for testing projectiles against.
+struct ProjectileTarget
+{
+	BASE_OBJECT *psObj;
+	Vector3i    pos;
+	Vector3i    prevPos;
+	ObjectShape shape;
+	int32_t     height;
+};
+
+#define PROJ_CELL_SHIFT 8  // Cells of the projectile broadphase are 2x2 tiles.
+
+// The projectile broadphase, built by proj_UpdateBroadphase once per tick. Each object is put in all the cells touched by
+// the area it moved through this tick, widened by its size, so a projectile only needs to test the objects in the cells
+// its own path crosses.
+static std::vector<ProjectileTarget> projTargets;  ///< In the order the grid gives them.
+static std::vector<unsigned> projCellStart;        ///< The objects in cell c are projCellTargets[projCellStart[c]] up to projCellTargets[projCellStart[c + 1]].
+static std::vector<unsigned> projCellTargets;      ///< Indices into projTargets.
+static std::vector<unsigned> projCellFill;         ///< Scratch space for filling projCellTargets.
+static std::vector<unsigned> projTargetTested;     ///< Which search last found each object, so that objects in several cells are only found once.
+static unsigned projSearch = 0;
+static int projCellsWidth = 0;
+static int projCellsHeight = 0;
+
 static ObjectShape establishTargetShape(BASE_OBJECT *psTarget);
 static void	proj_ImpactFunc(PROJECTILE *psObj);
 static void	proj_PostImpactFunc(PROJECTILE *psObj);
@@ -181,6 +207,20 @@ bool gfxVisible(PROJECTILE *psObj)
 
 /***************************************************************************/
 
+static WzPool projectilePool("PROJECTILE", sizeof(PROJECTILE));
+
+void *PROJECTILE::operator new(size_t size)
+{
+	return projectilePool.alloc(size);
+}
+
+void PROJECTILE::operator delete(void *ptr, size_t size)
+{
+	projectilePool.free(ptr, size);
+}
+
+/***************************************************************************/
+
 bool
 proj_InitSystem(void)
 {
@@ -210,6 +250,11 @@ bool
 proj_Shutdown(void)
 {
 	proj_FreeAllProjectiles();
+	projTargets.clear();
+	projCellStart.clear();
+	projCellTargets.clear();
+	projCellFill.clear();
+	projTargetTested.clear();
 
 	return true;
 }
@@ -672,6 +717,155 @@ static int32_t collisionXYZ(Vector3i v1, Vector3i v2, ObjectShape shape, int32_t
 	return -1;
 }
 
+static inline int projCellX(int32_t x)
+{
+	return clip(x >> PROJ_CELL_SHIFT, 0, projCellsWidth - 1);
+}
+
+static inline int projCellY(int32_t y)
+{
+	return clip(y >> PROJ_CELL_SHIFT, 0, projCellsHeight - 1);
+}
+
+/// Calls func(cell) for each cell which the target could be hit in.
+template<class Func>
+static void projForTargetCells(ProjectileTarget const &target, Func const &func)
+{
+	int extent = std::max(target.shape.size.x, target.shape.size.y) + 1;
+	int minX = projCellX(std::min(target.pos.x, target.prevPos.x) - extent);
+	int maxX = projCellX(std::max(target.pos.x, target.prevPos.x) + extent);
+	int minY = projCellY(std::min(target.pos.y, target.prevPos.y) - extent);
+	int maxY = projCellY(std::max(target.pos.y, target.prevPos.y) + extent);
+	for (int y = minY; y <= maxY; ++y)
+	{
+		for (int x = minX; x <= maxX; ++x)
+		{
+			func(x + y * projCellsWidth);
+		}
+	}
+}
+
+static void proj_UpdateBroadphase()
+{
+	projCellsWidth = (world_coord(mapWidth) >> PROJ_CELL_SHIFT) + 1;
+	projCellsHeight = (world_coord(mapHeight) >> PROJ_CELL_SHIFT) + 1;
+	unsigned numCells = projCellsWidth * projCellsHeight;
+
+	// Anything further off the map than PROJ_NEIGHBOUR_RANGE can't be hit, since projectiles die when leaving the map.
+	GridList const &gridList = gridStartIterateArea(-PROJ_NEIGHBOUR_RANGE, -PROJ_NEIGHBOUR_RANGE, world_coord(mapWidth) + PROJ_NEIGHBOUR_RANGE, world_coord(mapHeight) + PROJ_NEIGHBOUR_RANGE);
+	projTargets.clear();
+	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
+	{
+		BASE_OBJECT *psObj = *gi;
+		CHECK_OBJECT(psObj);
+
+		if (psObj->died)
+		{
+			continue;  // Dead objects stay dead, so can't be hit this tick.
+		}
+		ProjectileTarget target;
+		target.psObj = psObj;
+		target.pos = psObj->pos;
+		target.prevPos = isDroid(psObj) ? castDroid(psObj)->prevSpacetime.pos : psObj->pos;
+		target.shape = establishTargetShape(psObj);
+		target.height = establishTargetHeight(psObj);
+		projTargets.push_back(target);
+	}
+
+	// Count the objects in each cell, then fill them in.
+	projCellStart.assign(numCells + 1, 0);
+	for (unsigned i = 0; i < projTargets.size(); ++i)
+	{
+		projForTargetCells(projTargets[i], [](unsigned cell) { ++projCellStart[cell + 1]; });
+	}
+	for (unsigned cell = 0; cell < numCells; ++cell)
+	{
+		projCellStart[cell + 1] += projCellStart[cell];
+	}
+	projCellTargets.resize(projCellStart[numCells]);
+	projCellFill.assign(projCellStart.begin(), projCellStart.end() - 1);
+	for (unsigned i = 0; i < projTargets.size(); ++i)
+	{
+		projForTargetCells(projTargets[i], [i](unsigned cell) { projCellTargets[projCellFill[cell]++] = i; });
+	}
+
+	projTargetTested.assign(projTargets.size(), 0);
+	projSearch = 0;
+}
+
+/// Finds the objects in the cells crossed by the line from a to b, each only once.
+static void proj_FindTargets(Vector2i a, Vector2i b, std::vector<unsigned> &found)
+{
+	found.clear();
+	++projSearch;
+	if (a.y > b.y)
+	{
+		std::swap(a, b);
+	}
+
+	for (int cellY = projCellY(a.y); cellY <= projCellY(b.y); ++cellY)
+	{
+		// Find which cells of this row the line crosses. The outermost rows also cover everything off the map.
+		int32_t minX = std::min(a.x, b.x);
+		int32_t maxX = std::max(a.x, b.x);
+		if (a.y != b.y)
+		{
+			int32_t rowBegin = cellY == 0 ? a.y : std::max(a.y, cellY << PROJ_CELL_SHIFT);
+			int32_t rowEnd = cellY == projCellsHeight - 1 ? b.y : std::min(b.y, ((cellY + 1) << PROJ_CELL_SHIFT) - 1);
+			int32_t x1 = a.x + (int64_t)(rowBegin - a.y) * (b.x - a.x) / (b.y - a.y);
+			int32_t x2 = a.x + (int64_t)(rowEnd - a.y) * (b.x - a.x) / (b.y - a.y);
+			minX = std::max(minX, std::min(x1, x2) - 1);  // -1 and +1, in case of rounding.
+			maxX = std::min(maxX, std::max(x1, x2) + 1);
+		}
+		for (int cellX = projCellX(minX); cellX <= projCellX(maxX); ++cellX)
+		{
+			unsigned cell = cellX + cellY * projCellsWidth;
+			for (unsigned n = projCellStart[cell]; n < projCellStart[cell + 1]; ++n)
+			{
+				unsigned i = projCellTargets[n];
+				if (projTargetTested[i] != projSearch)
+				{
+					projTargetTested[i] = projSearch;
+					found.push_back(i);
+				}
+			}
+		}
+	}
+}
+
+/// Finds the objects with their centre within radius of pos, in the order the grid gives them.
+/// Only reads the broadphase, so several threads can search at once.
+static void proj_FindTargetsInRadius(Vector2i pos, int32_t radius, std::vector<unsigned> &found)
+{
+	found.clear();
+	int minX = projCellX(pos.x - radius);
+	int maxX = projCellX(pos.x + radius);
+	int minY = projCellY(pos.y - radius);
+	int maxY = projCellY(pos.y + radius);
+	for (int cellY = minY; cellY <= maxY; ++cellY)
+	{
+		for (int cellX = minX; cellX <= maxX; ++cellX)
+		{
+			unsigned cell = cellX + cellY * projCellsWidth;
+			for (unsigned n = projCellStart[cell]; n < projCellStart[cell + 1]; ++n)
+			{
+				unsigned i = projCellTargets[n];
+				ProjectileTarget const &target = projTargets[i];
+				if (projCellX(target.pos.x) != cellX || projCellY(target.pos.y) != cellY)
+				{
+					continue;  // Only look at each object in the cell its centre is in, so it's found only once.
+				}
+				int64_t dx = target.pos.x - pos.x, dy = target.pos.y - pos.y;
+				if (dx * dx + dy * dy <= (int64_t)radius * radius)
+				{
+					found.push_back(i);
+				}
+			}
+		}
+	}
+	std::sort(found.begin(), found.end());
+}
+
 static void proj_InFlightFunc(PROJECTILE *psProj)
 {
 	/* we want a delay between Las-Sats firing and actually hitting in multiPlayer
@@ -794,12 +988,14 @@ static void proj_InFlightFunc(PROJECTILE *psProj)
 
 	closestCollisionSpacetime.time = 0xFFFFFFFF;
 
-	/* Check nearby objects for possible collisions */
-	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(psProj->pos.x, psProj->pos.y, PROJ_NEIGHBOUR_RANGE);
-	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
+	/* Check objects along the path for possible collisions */
+	static std::vector<unsigned> targets;  // static to avoid allocations.
+	unsigned closestTarget = UINT32_MAX;
+	proj_FindTargets(psProj->prevSpacetime.pos.xy, psProj->pos.xy, targets);
+	for (unsigned n = 0; n < targets.size(); ++n)
 	{
-		BASE_OBJECT *psTempObj = *gi;
+		ProjectileTarget const &target = projTargets[targets[n]];
+		BASE_OBJECT *psTempObj = target.psObj;
 		CHECK_OBJECT(psTempObj);
 
 		if (std::find(psProj->psDamaged.begin(), psProj->psDamaged.end(), psTempObj) != psProj->psDamaged.end())
@@ -832,20 +1028,18 @@ static void proj_InFlightFunc(PROJECTILE *psProj)
 			continue;
 		}
 
-		Vector3i psTempObjPrevPos = isDroid(psTempObj) ? castDroid(psTempObj)->prevSpacetime.pos : psTempObj->pos;
-
-		const Vector3i diff = psProj->pos - psTempObj->pos;
-		const Vector3i prevDiff = psProj->prevSpacetime.pos - psTempObjPrevPos;
-		const unsigned int targetHeight = establishTargetHeight(psTempObj);
-		const ObjectShape targetShape = establishTargetShape(psTempObj);
-		const int32_t collision = collisionXYZ(prevDiff, diff, targetShape, targetHeight);
+		const Vector3i diff = psProj->pos - target.pos;
+		const Vector3i prevDiff = psProj->prevSpacetime.pos - target.prevPos;
+		const int32_t collision = collisionXYZ(prevDiff, diff, target.shape, target.height);
 		const uint32_t collisionTime = psProj->prevSpacetime.time + (psProj->time - psProj->prevSpacetime.time) * collision / 1024;
 
-		if (collision >= 0 && collisionTime < closestCollisionSpacetime.time)
+		// Where two objects are hit at the same time, the one first in the grid wins.
+		if (collision >= 0 && (collisionTime < closestCollisionSpacetime.time || (collisionTime == closestCollisionSpacetime.time && targets[n] < closestTarget)))
 		{
 			// We hit!
 			closestCollisionSpacetime = interpolateObjectSpacetime(psProj, collisionTime);
 			closestCollisionObject = psTempObj;
+			closestTarget = targets[n];
 
 			// Keep testing for more collisions, in case there was a closer target.
 		}
@@ -1155,11 +1349,11 @@ static void proj_ImpactFunc(PROJECTILE *psObj)
 		/* Note when it exploded for the explosion effect */
 		psObj->born = gameTime;
 
-		static GridList gridList;  // static to avoid allocations.
-		gridList = gridStartIterate(psObj->pos.x, psObj->pos.y, psStats->upgrade[psObj->player].radius);
-		for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
+		static std::vector<unsigned> targets;  // static to avoid allocations.
+		proj_FindTargetsInRadius(psObj->pos.xy, psStats->upgrade[psObj->player].radius, targets);
+		for (unsigned n = 0; n < targets.size(); ++n)
 		{
-			BASE_OBJECT *psCurr = *gi;
+			BASE_OBJECT *psCurr = projTargets[targets[n]].psObj;
 			if (psCurr->died)
 			{
 				continue;  // Do not damage dead objects further.
@@ -1319,6 +1513,33 @@ void proj_UpdateAll()
 {
 	std::vector<PROJECTILE *> psProjectileListOld = psProjectileList;
 
+	if (psProjectileListOld.empty())
+	{
+		return;
+	}
+	proj_UpdateBroadphase();
+
+	// Fires don't move, so find what is in all the existing fires at once. The damage is still done in order,
+	// by proj_checkPeriodicalDamage, since each projectile can kill things that the next would have hit.
+	static std::vector<PROJECTILE *> fires;  // static to avoid allocations.
+	fires.clear();
+	for (unsigned i = 0; i < psProjectileListOld.size(); ++i)
+	{
+		PROJECTILE *psProj = psProjectileListOld[i];
+		if (psProj->state == PROJ_POSTIMPACT && psProj->psWStats->upgrade[psProj->player].periodicalDamageTime != 0)
+		{
+			fires.push_back(psProj);
+		}
+	}
+	wzParallelFor(fires.size(), [](unsigned begin, unsigned end, unsigned) {
+		for (unsigned i = begin; i < end; ++i)
+		{
+			PROJECTILE *psProj = fires[i];
+			proj_FindTargetsInRadius(psProj->pos.xy, psProj->psWStats->upgrade[psProj->player].periodicalDamageRadius, psProj->inFire);
+			psProj->inFireFound = true;
+		}
+	});
+
 	// Update all projectiles. Penetrating projectiles may add to psProjectileList.
 	std::for_each(psProjectileListOld.begin(), psProjectileListOld.end(), std::mem_fun(&PROJECTILE::update));
 
@@ -1337,11 +1558,16 @@ static void proj_checkPeriodicalDamage(PROJECTILE *psProj)
 
 	WEAPON_STATS *psStats = psProj->psWStats;
 
-	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(psProj->pos.x, psProj->pos.y, psStats->upgrade[psProj->player].periodicalDamageRadius);
-	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
+	if (!psProj->inFireFound)
+	{
+		// Just hit something, so proj_UpdateAll didn't know where the fire would be.
+		proj_FindTargetsInRadius(psProj->pos.xy, psStats->upgrade[psProj->player].periodicalDamageRadius, psProj->inFire);
+	}
+	psProj->inFireFound = false;
+
+	for (unsigned n = 0; n < psProj->inFire.size(); ++n)
 	{
-		BASE_OBJECT *psCurr = *gi;
+		BASE_OBJECT *psCurr = projTargets[psProj->inFire[n]].psObj;
 		if (psCurr->died)
 		{
 			continue;  // Do not damage dead objects further.
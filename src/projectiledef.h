@@ -40,7 +40,10 @@ enum PROJ_STATE
 
 struct PROJECTILE : public SIMPLE_OBJECT
 {
-	PROJECTILE(uint32_t id, unsigned player) : SIMPLE_OBJECT(OBJ_PROJECTILE, id, player) {}
+	PROJECTILE(uint32_t id, unsigned player) : SIMPLE_OBJECT(OBJ_PROJECTILE, id, player), inFireFound(false) {}
+
+	static void *operator new(size_t size);            ///< Allocates from a WzPool.
+	static void operator delete(void *ptr, size_t size);
 
 	void            update();
 	bool            deleteIfDead()
@@ -66,6 +69,8 @@ struct PROJECTILE : public SIMPLE_OBJECT
 	Spacetime       prevSpacetime;          ///< Location of projectile in previous tick.
 	UDWORD          expectedDamageCaused;   ///< Expected damage that this projectile will cause to the target.
 	int             partVisible;            ///< how much of target was visible on shooting (important for homing)
+	std::vector<unsigned> inFire;           ///< Objects in the fire this tick, found by proj_UpdateAll, as indices into the targets of the projectile broadphase.
+	bool            inFireFound;            ///< Whether inFire has been found, and not used yet.
 };
 
 typedef std::vector<PROJECTILE *>::const_iterator ProjectileIterator;
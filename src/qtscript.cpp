@@ -50,7 +50,11 @@
 #include "console.h"
 #include "clparse.h"
 
+#include <algorithm>
+#include <map>
+#include <queue>
 #include <set>
+#include <vector>
 
 #include "qtscriptdebug.h"
 #include "qtscriptfuncs.h"
@@ -94,10 +98,16 @@ struct timerNode
 #define MAX_US 20000
 #define HALF_MAX_US 10000
 
-/// List of timer events for scripts. Before running them, we sort the list then run as many as we have time for.
-/// In this way, we implement load balancing of events and keep frame rates tidy for users. Since scripts run on the
-/// host, we do not need to worry about each peer simulating the world differently.
-static QList<timerNode> timers;
+/// Timer events for scripts, keyed by the order they were added in, which is also the order they run in when due
+/// in the same tick.
+static std::map<unsigned, timerNode> timers;
+static unsigned timerNextKey = 0;
+typedef std::pair<uint32_t, unsigned> TimerDue;  ///< When the timer is due, and its key in timers.
+/// When each timer is next due, soonest first. Removed timers and old due times are skipped when they come up.
+static std::priority_queue<TimerDue, std::vector<TimerDue>, std::greater<TimerDue> > timerQueue;
+static std::multimap<int, unsigned> timersByObject;  ///< Keys of the timers with each object id, for removing them when the object dies.
+static std::vector<unsigned> timersDone;             ///< Keys of one-shot timers which have run, removed on the next update.
+static std::map<int, unsigned> timerIntervalCount;   ///< How many repeating timers were added with each interval, for spreading them out.
 
 /// Scripting engine (what others call the scripting context, but QtScript's nomenclature is different).
 static QList<QScriptEngine *> scripts;
@@ -201,6 +211,42 @@ static QScriptValue callFunction(QScriptEngine *engine, const QString &function,
 	return result;
 }
 
+/// Adds a timer, to run after those already added, when due in the same tick.
+static void timerAdd(timerNode const &node)
+{
+	unsigned key = timerNextKey++;
+	timers.insert(std::make_pair(key, node));
+	if (node.type != TIMER_ONESHOT_DONE)
+	{
+		timerQueue.push(TimerDue(node.frameTime, key));
+	}
+	else
+	{
+		timersDone.push_back(key);
+	}
+	if (node.baseobj != -1)
+	{
+		timersByObject.insert(std::make_pair(node.baseobj, key));
+	}
+}
+
+static void timerRemove(std::map<unsigned, timerNode>::iterator i)
+{
+	if (i->second.baseobj != -1)
+	{
+		std::pair<std::multimap<int, unsigned>::iterator, std::multimap<int, unsigned>::iterator> range = timersByObject.equal_range(i->second.baseobj);
+		for (std::multimap<int, unsigned>::iterator j = range.first; j != range.second; ++j)
+		{
+			if (j->second == i->first)
+			{
+				timersByObject.erase(j);
+				break;
+			}
+		}
+	}
+	timers.erase(i);  // Any entry in timerQueue is skipped when it comes up.
+}
+
 //-- \subsection{setTimer(function, milliseconds[, object])}
 //-- Set a function to run repeated at some given time interval. The function to run
 //-- is the first parameter, and it \underline{must be quoted}, otherwise the function will
@@ -208,6 +254,8 @@ static QScriptValue callFunction(QScriptEngine *engine, const QString &function,
 //-- parameter can be a \emph{game object} to pass to the timer function. If the \emph{game object}
 //-- dies, the timer stops running. The minimum number of milliseconds is 100, but such
 //-- fast timers are strongly discouraged as they may deteriorate the game performance.
+//-- In skirmish and multiplayer games, timers with the same interval are spread over different
+//-- game frames, so the first call may come up to one interval later.
 //--
 //-- \begin{lstlisting}
 //--   function conDroids()
@@ -241,7 +289,13 @@ static QScriptValue js_setTimer(QScriptContext *context, QScriptEngine *engine)
 		}
 	}
 	node.type = TIMER_REPEAT;
-	timers.push_back(node);
+	if (bMultiPlayer && node.ms > 0)
+	{
+		// Many AIs set timers with the same intervals at the start of the game, so don't run them all in the same tick.
+		unsigned phase = timerIntervalCount[node.ms]++;
+		node.frameTime += phase * GAME_TICKS_PER_UPDATE % node.ms;
+	}
+	timerAdd(node);
 	return QScriptValue();
 }
 
@@ -252,17 +306,16 @@ static QScriptValue js_removeTimer(QScriptContext *context, QScriptEngine *engin
 {
 	SCRIPT_ASSERT(context, context->argument(0).isString(), "Timer functions must be quoted");
 	QString function = context->argument(0).toString();
-	int i, size = timers.size();
-	for (i = 0; i < size; ++i)
+	std::map<unsigned, timerNode>::iterator i = timers.begin();
+	while (i != timers.end() && i->second.function != function)
 	{
-		timerNode node = timers.at(i);
-		if (node.function == function)
-		{
-			timers.removeAt(i);
-			break;
-		}
+		++i;
+	}
+	if (i != timers.end())
+	{
+		timerRemove(i);
 	}
-	if (i == size)
+	else
 	{
 		// Friendly warning
 		QString warnName = function.left(15) + "...";
@@ -310,7 +363,7 @@ static QScriptValue js_queue(QScriptContext *context, QScriptEngine *engine)
 		}
 	}
 	node.type = TIMER_ONESHOT_READY;
-	timers.push_back(node);
+	timerAdd(node);
 	return QScriptValue();
 }
 
@@ -334,17 +387,10 @@ static QScriptValue js_profile(QScriptContext *context, QScriptEngine *engine)
 void scriptRemoveObject(BASE_OBJECT *psObj)
 {
 	// Weed out timers with dead objects
-	for (int i = 0; i < timers.count();)
+	std::multimap<int, unsigned>::iterator i;
+	while ((i = timersByObject.find(psObj->id)) != timersByObject.end())
 	{
-		const timerNode node = timers.at(i);
-		if (node.baseobj == psObj->id)
-		{
-			timers.removeAt(i);
-		}
-		else
-		{
-			i++;
-		}
+		timerRemove(timers.find(i->second));
 	}
 	groupRemoveObject(psObj);
 }
@@ -450,6 +496,10 @@ bool shutdownScripts()
 		unregisterFunctions(engine);
 	}
 	timers.clear();
+	timerQueue = std::priority_queue<TimerDue, std::vector<TimerDue>, std::greater<TimerDue> >();
+	timersByObject.clear();
+	timersDone.clear();
+	timerIntervalCount.clear();
 	internalNamespace.clear();
 	monitors.clear();
 	while (!scripts.isEmpty())
@@ -482,36 +532,48 @@ bool updateScripts()
 		engine->globalObject().setProperty("gameTime", gameTime, QScriptValue::ReadOnly | QScriptValue::Undeletable);
 	}
 	// Weed out dead timers
-	for (int i = 0; i < timers.count();)
+	for (unsigned i = 0; i < timersDone.size(); ++i)
 	{
-		const timerNode node = timers.at(i);
-		if (node.type == TIMER_ONESHOT_DONE)
+		std::map<unsigned, timerNode>::iterator node = timers.find(timersDone[i]);
+		if (node != timers.end())
 		{
-			timers.removeAt(i);
+			timerRemove(node);
 		}
-		else
+	}
+	timersDone.clear();
+	// Find the timers which are due, and run them in the order they were added.
+	static std::vector<unsigned> due;  // static to avoid allocations.
+	due.clear();
+	while (!timerQueue.empty() && timerQueue.top().first <= gameTime)
+	{
+		TimerDue next = timerQueue.top();
+		timerQueue.pop();
+		std::map<unsigned, timerNode>::iterator node = timers.find(next.second);
+		if (node != timers.end() && (uint32_t)node->second.frameTime == next.first && node->second.type != TIMER_ONESHOT_DONE)
 		{
-			i++;
+			due.push_back(next.second);
 		}
 	}
-	// Check for timers, and run them if applicable.
-	// TODO - load balancing
+	std::sort(due.begin(), due.end());
+	due.erase(std::unique(due.begin(), due.end()), due.end());
 	QList<timerNode> runlist; // make a new list here, since we might trample all over the timer list during execution
-	QList<timerNode>::iterator iter;
-	for (iter = timers.begin(); iter != timers.end(); iter++)
+	for (unsigned i = 0; i < due.size(); ++i)
 	{
-		if (iter->frameTime <= gameTime)
+		timerNode &node = timers.find(due[i])->second;
+		node.frameTime = node.ms + gameTime;	// update for next invokation
+		if (node.type == TIMER_ONESHOT_READY)
 		{
-			iter->frameTime = iter->ms + gameTime;	// update for next invokation
-			if (iter->type == TIMER_ONESHOT_READY)
-			{
-				iter->type = TIMER_ONESHOT_DONE; // unless there is none
-			}
-			iter->calls++;
-			runlist.append(*iter);
+			node.type = TIMER_ONESHOT_DONE; // unless there is none
+			timersDone.push_back(due[i]);
+		}
+		else
+		{
+			timerQueue.push(TimerDue(node.frameTime, due[i]));
 		}
+		node.calls++;
+		runlist.append(node);
 	}
-	for (iter = runlist.begin(); iter != runlist.end(); iter++)
+	for (QList<timerNode>::iterator iter = runlist.begin(); iter != runlist.end(); iter++)
 	{
 		QScriptValueList args;
 		if (iter->baseobj > 0)
@@ -681,10 +743,11 @@ bool saveScriptStates(const char *filename)
 		saveGroups(ini, engine);
 		ini.endGroup();
 	}
-	for (int i = 0; i < timers.size(); ++i)
+	int triggerNum = 0;
+	for (std::map<unsigned, timerNode>::const_iterator i = timers.begin(); i != timers.end(); ++i, ++triggerNum)
 	{
-		timerNode node = timers.at(i);
-		ini.beginGroup(QString("triggers_") + QString::number(i));
+		timerNode const &node = i->second;
+		ini.beginGroup(QString("triggers_") + QString::number(triggerNum));
 		// we have to save 'scriptName' and 'me' explicitly
 		ini.setValue("me", node.player);
 		ini.setValue("scriptName", node.engine->globalObject().property("scriptName").toString());
@@ -741,7 +804,7 @@ bool loadScriptStates(const char *filename)
 			node.function = ini.value("function").toString();
 			node.baseobj = ini.value("baseobj", -1).toInt();
 			node.type = (timerType)ini.value("type", TIMER_REPEAT).toInt();
-			timers.push_back(node);
+			timerAdd(node);
 		}
 		else if (engine && list[i].startsWith("globals_"))
 		{
@@ -821,9 +884,9 @@ static void updateGlobalModels()
 	}
 	QStandardItemModel *m = triggerModel;
 	m->setRowCount(0);
-	for (int i = 0; i < timers.size(); ++i)
+	for (std::map<unsigned, timerNode>::const_iterator i = timers.begin(); i != timers.end(); ++i)
 	{
-		timerNode node = timers.at(i);
+		timerNode const &node = i->second;
 		int nextRow = m->rowCount();
 		m->setRowCount(nextRow);
 		m->setItem(nextRow, 0, new QStandardItem(node.function));
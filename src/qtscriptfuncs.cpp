@@ -1595,10 +1595,11 @@ static QScriptValue js_enumResearch(QScriptContext *context, QScriptEngine *engi
 {
 	QList<RESEARCH *> reslist;
 	int player = engine->globalObject().property("me").toInt32();
-	for (int i = 0; i < asResearch.size(); i++)
+	std::vector<int> const &candidates = researchCandidates(player);
+	for (std::vector<int>::const_iterator i = candidates.begin(); i != candidates.end(); ++i)
 	{
-		RESEARCH *psResearch = &asResearch[i];
-		if (!IsResearchCompleted(&asPlayerResList[player][i]) && researchAvailable(i, player, ModeQueue))
+		RESEARCH *psResearch = &asResearch[*i];
+		if (!IsResearchCompleted(&asPlayerResList[player][*i]) && researchAvailable(*i, player, ModeQueue))
 		{
 			reslist += psResearch;
 		}
@@ -3386,7 +3387,6 @@ static QScriptValue js_addStructure(QScriptContext *context, QScriptEngine *engi
 	STRUCTURE *psStruct = buildStructure(psStat, x, y, player, false);
 	if (psStruct)
 	{
-		psStruct->status = SS_BUILT;
 		buildingComplete(psStruct);
 		return QScriptValue(convStructure(psStruct, engine));
 	}
@@ -0,0 +1,295 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2016  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Recording of multiplayer and skirmish games, and playing them back.
+ *
+ *  The game messages themselves are recorded by lib/netplay/netreplay.cpp. This stores the game settings needed
+ *  to start the same game again, as a JSON object in the replay header.
+ */
+
+#include "lib/framework/frame.h"
+#include "lib/netplay/netplay.h"
+#include "lib/netplay/netreplay.h"
+
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <physfs.h>
+#include <time.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "replay.h"
+#include "ai.h"
+#include "component.h"
+#include "data.h"
+#include "frontend.h"
+#include "levels.h"
+#include "multiplay.h"
+#include "random.h"
+#include "warzoneconfig.h"
+
+extern char MultiCustomMapsPath[PATH_MAX];
+
+static uint32_t replayDataHash[DATA_MAXDATA];  ///< DataHash of the game that was recorded, when playing back.
+
+static std::string replaySaveSettings()
+{
+	QJsonObject settings;
+
+	settings["type"] = game.type;
+	settings["scavengers"] = game.scavengers;
+	settings["map"] = QString::fromUtf8(game.map);
+	settings["maxPlayers"] = game.maxPlayers;
+	settings["name"] = QString::fromUtf8(game.name);
+	settings["hash"] = QString::fromStdString(game.hash.toString());
+	settings["power"] = (qint64)game.power;
+	settings["base"] = game.base;
+	settings["alliance"] = game.alliance;
+	settings["mapHasScavengers"] = game.mapHasScavengers;
+	settings["isMapMod"] = game.isMapMod;
+	settings["seed"] = (qint64)gameRandSeed();
+	settings["selectedPlayer"] = (qint64)selectedPlayer;
+	settings["hostPlayer"] = (qint64)NetPlay.hostPlayer;
+
+	QJsonArray players, allianceRows;
+	for (unsigned i = 0; i < MAX_PLAYERS; ++i)
+	{
+		QJsonObject player;
+		player["name"] = QString::fromUtf8(NetPlay.players[i].name);
+		player["position"] = NetPlay.players[i].position;
+		player["colour"] = NetPlay.players[i].colour;
+		player["allocated"] = NetPlay.players[i].allocated;
+		player["team"] = NetPlay.players[i].team;
+		player["ai"] = NetPlay.players[i].ai;
+		player["difficulty"] = NetPlay.players[i].difficulty;
+		player["skDiff"] = game.skDiff[i];
+		players.append(player);
+
+		QJsonArray row;
+		for (unsigned j = 0; j < MAX_PLAYERS; ++j)
+		{
+			row.append(alliances[i][j]);
+		}
+		allianceRows.append(row);
+	}
+	settings["players"] = players;
+	settings["alliances"] = allianceRows;
+
+	QJsonArray limits;
+	for (unsigned i = 0; i < ingame.numStructureLimits; ++i)
+	{
+		QJsonArray limit;
+		limit.append((qint64)ingame.pStructureLimits[i].id);
+		limit.append((qint64)ingame.pStructureLimits[i].limit);
+		limits.append(limit);
+	}
+	settings["structureLimits"] = limits;
+	settings["limitFlags"] = ingame.flags;
+
+	QJsonArray dataHash;
+	for (unsigned i = 0; i < DATA_MAXDATA; ++i)
+	{
+		dataHash.append((qint64)DataHash[i]);
+	}
+	settings["dataHash"] = dataHash;
+
+	QByteArray json = QJsonDocument(settings).toJson(QJsonDocument::Compact);
+	return std::string(json.constData(), json.size());
+}
+
+static bool replayLoadSettings(std::string const &data)
+{
+	QJsonParseError error;
+	QJsonDocument doc = QJsonDocument::fromJson(QByteArray(data.data(), data.size()), &error);
+	if (!doc.isObject())
+	{
+		debug(LOG_ERROR, "Bad replay settings: %s", error.errorString().toUtf8().constData());
+		return false;
+	}
+	QJsonObject settings = doc.object();
+	QJsonArray players = settings["players"].toArray();
+	QJsonArray allianceRows = settings["alliances"].toArray();
+	QJsonArray dataHash = settings["dataHash"].toArray();
+	if (players.size() != MAX_PLAYERS || allianceRows.size() != MAX_PLAYERS || dataHash.size() != DATA_MAXDATA)
+	{
+		debug(LOG_ERROR, "Replay was recorded with a different number of players or data types");
+		return false;
+	}
+
+	NetPlay.bComms = false;
+	NetPlay.isHost = false;
+	NetPlay.hostPlayer = settings["hostPlayer"].toInt();
+	bMultiPlayer = true;
+	bMultiMessages = true;
+	ingame.localJoiningInProgress = false;
+	ingame.localOptionsReceived = true;
+
+	game.type = settings["type"].toInt();
+	game.scavengers = settings["scavengers"].toBool();
+	sstrcpy(game.map, settings["map"].toString().toUtf8().constData());
+	game.maxPlayers = settings["maxPlayers"].toInt();
+	sstrcpy(game.name, settings["name"].toString().toUtf8().constData());
+	game.hash.fromString(settings["hash"].toString().toStdString());
+	game.power = settings["power"].toDouble();
+	game.base = settings["base"].toInt();
+	game.alliance = settings["alliance"].toInt();
+	game.mapHasScavengers = settings["mapHasScavengers"].toBool();
+	game.isMapMod = settings["isMapMod"].toBool();
+	selectedPlayer = realSelectedPlayer = settings["selectedPlayer"].toInt();
+
+	for (unsigned i = 0; i < MAX_PLAYERS; ++i)
+	{
+		QJsonObject player = players[i].toObject();
+		NET_InitPlayer(i, true, false);
+		sstrcpy(NetPlay.players[i].name, player["name"].toString().toUtf8().constData());
+		NetPlay.players[i].position = player["position"].toInt();
+		NetPlay.players[i].colour = player["colour"].toInt();
+		setPlayerColour(i, NetPlay.players[i].colour);
+		NetPlay.players[i].allocated = player["allocated"].toBool();
+		NetPlay.players[i].team = player["team"].toInt();
+		NetPlay.players[i].ai = player["ai"].toInt();
+		NetPlay.players[i].difficulty = player["difficulty"].toInt();
+		game.skDiff[i] = player["skDiff"].toInt();
+
+		QJsonArray row = allianceRows[i].toArray();
+		for (unsigned j = 0; j < MAX_PLAYERS; ++j)
+		{
+			alliances[i][j] = row[j].toInt();
+		}
+	}
+
+	QJsonArray limits = settings["structureLimits"].toArray();
+	free(ingame.pStructureLimits);
+	ingame.pStructureLimits = NULL;
+	ingame.numStructureLimits = limits.size();
+	if (ingame.numStructureLimits)
+	{
+		ingame.pStructureLimits = (MULTISTRUCTLIMITS *)malloc(ingame.numStructureLimits * sizeof(MULTISTRUCTLIMITS));
+	}
+	for (unsigned i = 0; i < ingame.numStructureLimits; ++i)
+	{
+		QJsonArray limit = limits[i].toArray();
+		ingame.pStructureLimits[i].id = limit[0].toDouble();
+		ingame.pStructureLimits[i].limit = limit[1].toDouble();
+	}
+	ingame.flags = settings["limitFlags"].toInt();
+
+	for (unsigned i = 0; i < DATA_MAXDATA; ++i)
+	{
+		replayDataHash[i] = dataHash[i].toDouble();
+	}
+	resetDataHash();
+
+	gameSRand(settings["seed"].toDouble());
+
+	// Same as decideWRF(), a downloaded map takes precedence over a built in one.
+	ssprintf(aLevelName, "%s%s.wrf", MultiCustomMapsPath, game.map);
+	if (!PHYSFS_exists(aLevelName))
+	{
+		sstrcpy(aLevelName, game.map);
+	}
+	return true;
+}
+
+bool replayLoad(const char *filename)
+{
+	std::string settings;
+	if (!NETreplayLoadStart(filename, settings))
+	{
+		return false;
+	}
+	if (!replayLoadSettings(settings))
+	{
+		NETreplayLoadStop();
+		return false;
+	}
+	debug(LOG_INFO, "Playing back %s on %s as player %u", filename, game.map, selectedPlayer);
+	return true;
+}
+
+/// Deletes the oldest recorded games, so that only the last keep replays remain.
+static void replayPrune(int keep)
+{
+	std::vector<std::string> replays;
+	char **files = PHYSFS_enumerateFiles("replay");
+	for (char **file = files; *file != nullptr; ++file)
+	{
+		std::string name = *file;
+		if (name.size() > 5 && name.compare(name.size() - 5, 5, ".wzrp") == 0)
+		{
+			replays.push_back(name);
+		}
+	}
+	PHYSFS_freeList(files);
+
+	if (replays.size() <= (size_t)keep)
+	{
+		return;
+	}
+	// Sort by the timestamp after the "skirmish-" or "multiplay-" prefix, oldest first.
+	auto timestamp = [](std::string const &name) { return name.substr(name.find('-') + 1); };
+	std::sort(replays.begin(), replays.end(), [&](std::string const &a, std::string const &b) { return timestamp(a) < timestamp(b); });
+	for (size_t i = 0; i < replays.size() - keep; ++i)
+	{
+		std::string path = "replay/" + replays[i];
+		if (!PHYSFS_delete(path.c_str()))
+		{
+			debug(LOG_WARNING, "Could not delete old replay %s: %s", path.c_str(), PHYSFS_getLastError());
+		}
+	}
+}
+
+void replayGameStart()
+{
+	if (NETisReplay())
+	{
+		if (memcmp(DataHash, replayDataHash, sizeof(DataHash)) != 0)
+		{
+			debug(LOG_WARNING, "Game data differs from when the replay was recorded, so the replay will probably go out of synch.");
+		}
+		return;
+	}
+
+	if (!bMultiPlayer)
+	{
+		return;  // Campaign games are not recorded.
+	}
+	int keep = war_getReplayKeep();
+	if (keep <= 0)
+	{
+		return;  // Recording is off, unless replayKeep is set in the config file.
+	}
+
+	time_t aclock;
+	char filename[256];
+
+	time(&aclock);
+	struct tm *newtime = localtime(&aclock);
+	snprintf(filename, sizeof(filename), "replay/%s-%04d%02d%02d_%02d%02d%02d.wzrp", game.type == SKIRMISH && !NetPlay.bComms ? "skirmish" : "multiplay", newtime->tm_year + 1900, newtime->tm_mon + 1, newtime->tm_mday, newtime->tm_hour, newtime->tm_min, newtime->tm_sec);
+	NETreplaySaveStart(filename, replaySaveSettings());
+	replayPrune(keep);
+}
+
+void replayGameStop()
+{
+	NETreplaySaveStop();
+	NETreplayLoadStop();
+}
@@ -0,0 +1,35 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2016  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Recording of multiplayer and skirmish games, and playing them back.
+ */
+
+#ifndef __INCLUDED_SRC_REPLAY_H__
+#define __INCLUDED_SRC_REPLAY_H__
+
+/// Sets up the game settings from a replay file, and sets aLevelName, so that the game can be started as normal.
+bool replayLoad(const char *filename);
+
+/// Called after the level is loaded. Starts recording a multiplayer or skirmish game, or checks that a replay is using the same data as when it was recorded.
+void replayGameStart();
+
+/// Called when the game ends. Stops recording or playing back.
+void replayGameStop();
+
+#endif // __INCLUDED_SRC_REPLAY_H__
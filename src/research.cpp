@@ -61,6 +61,11 @@ SDWORD					CBResFacilityOwner;
 //List of pointers to arrays of PLAYER_RESEARCH[numResearch] for each player
 std::vector<PLAYER_RESEARCH> asPlayerResList[MAX_PLAYERS];
 
+//the topics each player might be able to research, see researchCandidates()
+static std::vector<int>  researchCandidateList[MAX_PLAYERS];
+static std::vector<bool> researchCandidateFlags[MAX_PLAYERS];   // whether each topic is in researchCandidateList
+static bool              researchCandidatesDirty[MAX_PLAYERS];  // whether researchCandidateList needs working out again
+
 /* Default level of sensor, Repair and ECM */
 UDWORD					aDefaultSensor[MAX_PLAYERS];
 UDWORD					aDefaultECM[MAX_PLAYERS];
@@ -351,8 +356,55 @@ bool loadResearch(QString filename)
 	return true;
 }
 
+void researchCandidatesChanged(int player)
+{
+	researchCandidatesDirty[player] = true;
+}
+
+std::vector<int> const &researchCandidates(int player)
+{
+	std::vector<int> &list = researchCandidateList[player];
+	std::vector<bool> &flags = researchCandidateFlags[player];
+	if (!researchCandidatesDirty[player] && flags.size() == asResearch.size())
+	{
+		return list;
+	}
+	researchCandidatesDirty[player] = false;
+
+	// A topic can only be available if it was cancelled, made possible, or has all its pre-requisites, and only
+	// completing, cancelling or enabling research changes those. The rest of researchAvailable is cheap, so is
+	// checked each time.
+	list.clear();
+	flags.assign(asResearch.size(), false);
+	for (int inc = 0; inc < asResearch.size(); inc++)
+	{
+		PLAYER_RESEARCH const *psPlayerRes = &asPlayerResList[player][inc];
+		bool candidate = (psPlayerRes->ResearchStatus & (CANCELLED_RESEARCH | CANCELLED_RESEARCH_PENDING)) != 0;
+		if (!candidate && !IsResearchCompleted(psPlayerRes))
+		{
+			candidate = IsResearchPossible(psPlayerRes) || !asResearch[inc].pPRList.empty();
+			for (int incPR = 0; candidate && !IsResearchPossible(psPlayerRes) && incPR < asResearch[inc].pPRList.size(); incPR++)
+			{
+				candidate = IsResearchCompleted(&asPlayerResList[player][asResearch[inc].pPRList[incPR]]);
+			}
+		}
+		if (candidate)
+		{
+			list.push_back(inc);
+			flags[inc] = true;
+		}
+	}
+	return list;
+}
+
 bool researchAvailable(int inc, int playerID, QUEUE_MODE mode)
 {
+	researchCandidates(playerID);
+	if (!researchCandidateFlags[playerID][inc])
+	{
+		return false;
+	}
+
 	// Decide whether to use IsResearchCancelledPending/IsResearchStartedPending or IsResearchCancelled/IsResearchStarted.
 	bool (*IsResearchCancelledFunc)(PLAYER_RESEARCH const *) = IsResearchCancelledPending;
 	bool (*IsResearchStartedFunc)(PLAYER_RESEARCH const *) = IsResearchStartedPending;
@@ -463,20 +515,33 @@ There can only be 'limit' number of entries
 // NOTE by AJL may 99 - skirmish now has it's own version of this, skTopicAvail.
 UWORD fillResearchList(UWORD *plist, UDWORD playerID, UWORD topic, UWORD limit)
 {
-	UWORD				inc, count = 0;
+	UWORD				count = 0;
+	bool				topicAdded = topic >= asResearch.size();
+	std::vector<int> const &candidates = researchCandidates(playerID);
 
-	for (inc = 0; inc < asResearch.size(); inc++)
+	for (std::vector<int>::const_iterator inc = candidates.begin(); inc != candidates.end() && count < limit; ++inc)
 	{
 		// if the inc matches the 'topic' - automatically add to the list
-		if (inc == topic || researchAvailable(inc, playerID, ModeQueue))
+		if (!topicAdded && topic <= *inc)
 		{
-			*plist++ = inc;
+			*plist++ = topic;
 			count++;
-			if (count == limit)
+			topicAdded = true;
+			if (topic == *inc || count == limit)
 			{
-				return count;
+				continue;
 			}
 		}
+		if (researchAvailable(*inc, playerID, ModeQueue))
+		{
+			*plist++ = *inc;
+			count++;
+		}
+	}
+	if (!topicAdded && count < limit)
+	{
+		*plist++ = topic;
+		count++;
 	}
 	return count;
 }
@@ -494,6 +559,7 @@ void researchResult(UDWORD researchIndex, UBYTE player, bool bDisplay, STRUCTURE
 	syncDebug("researchResult(%u, %u, …)", researchIndex, player);
 
 	MakeResearchCompleted(&asPlayerResList[player][researchIndex]);
+	researchCandidatesChanged(player);
 
 	//check for structures to be made available
 	for (int inc = 0; inc < pResearch->pStructureResults.size(); inc++)
@@ -626,6 +692,9 @@ void ResearchRelease(void)
 	for (int i = 0; i < MAX_PLAYERS; i++)
 	{
 		asPlayerResList[i].clear();
+		researchCandidateList[i].clear();
+		researchCandidateFlags[i].clear();
+		researchCandidatesDirty[i] = true;
 	}
 }
 
@@ -730,6 +799,7 @@ void cancelResearch(STRUCTURE *psBuilding, QUEUE_MODE mode)
 			sendResearchStatus(psBuilding, topicInc, psBuilding->player, false);
 			// Immediately tell the UI that we can research this now. (But don't change the game state.)
 			MakeResearchCancelledPending(pPlayerRes);
+			researchCandidatesChanged(psBuilding->player);
 			setStatusPendingCancel(*psResFac);
 			return;  // Wait for our message before doing anything. (Whatever this function does...)
 		}
@@ -744,6 +814,7 @@ void cancelResearch(STRUCTURE *psBuilding, QUEUE_MODE mode)
 		{
 			// Set the researched flag
 			MakeResearchCancelled(pPlayerRes);
+			researchCandidatesChanged(psBuilding->player);
 		}
 
 		// Initialise the research facility's subject
@@ -1118,6 +1189,7 @@ bool enableResearch(RESEARCH *psResearch, UDWORD player)
 
 	//found, so set the flag
 	MakeResearchPossible(&asPlayerResList[player][inc]);
+	researchCandidatesChanged(player);
 
 	if (player == selectedPlayer)
 	{
@@ -141,6 +141,11 @@ void CancelAllResearch(UDWORD pl);
 extern bool researchInitVars(void);
 
 bool researchAvailable(int inc, int playerID, QUEUE_MODE mode);
+/// The topics the player might be able to research, in order. Includes every topic researchAvailable() accepts, and
+/// maybe some it doesn't, so is only worked out again when research is completed, cancelled or made possible.
+std::vector<int> const &researchCandidates(int player);
+/// Call after changing the research status of the player directly, rather than through researchResult(), cancelResearch() or enableResearch().
+void researchCandidatesChanged(int player);
 
 struct AllyResearch
 {
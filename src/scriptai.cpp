@@ -1523,15 +1523,18 @@ bool scrSkDoResearch(void)
 	}
 
 	// choose a topic to complete.
-	for (i = 0; i < asResearch.size(); i++)
+	std::vector<int> const &candidates = researchCandidates(player);
+	std::vector<int>::const_iterator topic;
+	for (topic = candidates.begin(); topic != candidates.end(); ++topic)
 	{
+		i = *topic;
 		if (skTopicAvail(i, player) && (!bMultiPlayer || !beingResearchedByAlly(i, player)))
 		{
 			break;
 		}
 	}
 
-	if (i != asResearch.size())
+	if (topic != candidates.end())
 	{
 		sendResearchStatus(psBuilding, i, player, true);			// inform others, I'm researching this.
 #if defined (DEBUG)
@@ -1851,7 +1851,6 @@ bool scrAddStructure(void)
 		psStruct = buildStructure(psStat, iX, iY, iPlayer, false);
 		if (psStruct != NULL)
 		{
-			psStruct->status = SS_BUILT;
 			buildingComplete(psStruct);
 
 			/*
@@ -10037,6 +10036,7 @@ bool scrSetTileHeight(void)
 	psTile = mapTile(tileX, tileY);
 
 	psTile->height = (UBYTE)newHeight * ELEVATION_SCALE;
+	mapHeightChanged(tileX, tileY);
 
 	return true;
 }
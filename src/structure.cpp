@@ -31,6 +31,7 @@
 #include "lib/framework/frame.h"
 #include "lib/framework/geometry.h"
 #include "lib/framework/wzconfig.h"
+#include "lib/framework/wzpool.h"
 #include "lib/ivis_opengl/imd.h"
 #include "objects.h"
 #include "ai.h"
@@ -107,6 +108,9 @@ STRUCTURE_STATS		*asStructureStats;
 UDWORD				numStructureStats;
 //holder for the limits of each structure per map
 STRUCTURE_LIMITS	*asStructLimits[MAX_PLAYERS];
+//the number of structures of each type per player, and how many of those are finished, like the quantities in asStructLimits
+static uint32_t		structTypeQuantity[MAX_PLAYERS][NUM_DIFF_BUILDINGS];
+static uint32_t		structTypeBuiltQuantity[MAX_PLAYERS][NUM_DIFF_BUILDINGS];
 
 //used to hold the modifiers cross refd by weapon effect and structureStrength
 STRUCTSTRENGTH_MODIFIER		asStructStrengthModifier[WE_NUMEFFECTS][NUM_STRUCT_STRENGTH];
@@ -592,6 +596,7 @@ void initStructLimits(void)
 		{
 			psStructLimits[i].limit = LOTS_OF;
 			psStructLimits[i].currentQuantity = 0;
+			psStructLimits[i].builtQuantity = 0;
 			psStructLimits[i].globalLimit = LOTS_OF;
 			if (isLasSat(psStat) || psStat->type == REF_SAT_UPLINK)
 			{
@@ -603,6 +608,38 @@ void initStructLimits(void)
 	}
 }
 
+/* add (count = 1) or remove (count = -1) the structure from the number of structures of its type and player */
+static void countStructure(STRUCTURE *psStruct, int count)
+{
+	STRUCTURE_LIMITS *psStructLimit = &asStructLimits[psStruct->player][psStruct->pStructureType - asStructureStats];
+	uint32_t *typeQuantity = &structTypeQuantity[psStruct->player][psStruct->pStructureType->type];
+	uint32_t *typeBuiltQuantity = &structTypeBuiltQuantity[psStruct->player][psStruct->pStructureType->type];
+
+	//don't allow to go less than zero!
+	psStructLimit->currentQuantity = std::max<int>(psStructLimit->currentQuantity + count, 0);
+	*typeQuantity = std::max<int>(*typeQuantity + count, 0);
+	if (psStruct->status == SS_BUILT)
+	{
+		psStructLimit->builtQuantity = std::max<int>(psStructLimit->builtQuantity + count, 0);
+		*typeBuiltQuantity = std::max<int>(*typeBuiltQuantity + count, 0);
+	}
+}
+
+/* change the status of a structure, keeping the number of finished structures up to date */
+static void setStructureStatus(STRUCTURE *psStruct, STRUCT_STATES status)
+{
+	if ((psStruct->status == SS_BUILT) != (status == SS_BUILT))
+	{
+		int count = status == SS_BUILT ? 1 : -1;
+		STRUCTURE_LIMITS *psStructLimit = &asStructLimits[psStruct->player][psStruct->pStructureType - asStructureStats];
+		uint32_t *typeBuiltQuantity = &structTypeBuiltQuantity[psStruct->player][psStruct->pStructureType->type];
+
+		psStructLimit->builtQuantity = std::max<int>(psStructLimit->builtQuantity + count, 0);
+		*typeBuiltQuantity = std::max<int>(*typeBuiltQuantity + count, 0);
+	}
+	psStruct->status = status;
+}
+
 /* set the current number of structures of each type built */
 void setCurrentStructQuantity(bool displayError)
 {
@@ -617,13 +654,16 @@ void setCurrentStructQuantity(bool displayError)
 		for (inc = 0; inc < numStructureStats; inc++)
 		{
 			psStructLimits[inc].currentQuantity = 0;
+			psStructLimits[inc].builtQuantity = 0;
 		}
+		memset(structTypeQuantity[player], 0, sizeof(structTypeQuantity[player]));
+		memset(structTypeBuiltQuantity[player], 0, sizeof(structTypeBuiltQuantity[player]));
 
 		for (psCurr = apsStructLists[player]; psCurr != NULL; psCurr =
 		         psCurr->psNext)
 		{
 			inc = psCurr->pStructureType - asStructureStats;
-			psStructLimits[inc].currentQuantity++;
+			countStructure(psCurr, 1);
 			if (displayError)
 			{
 				//check quantity never exceeds the limit
@@ -878,7 +918,7 @@ void structureBuild(STRUCTURE *psStruct, DROID *psDroid, int buildPoints, int bu
 	else
 	{
 		STRUCT_STATES prevStatus = psStruct->status;
-		psStruct->status = SS_BEING_BUILT;
+		setStructureStatus(psStruct, SS_BEING_BUILT);
 		if (prevStatus == SS_BUILT)
 		{
 			// Starting to demolish.
@@ -1593,7 +1633,7 @@ STRUCTURE *buildStructureDir(STRUCTURE_STATS *pStructureType, UDWORD x, UDWORD y
 		addStructure(psBuilding);
 
 		clustNewStruct(psBuilding);
-		asStructLimits[player][max].currentQuantity++;
+		countStructure(psBuilding, 1);
 
 		if (isLasSat(psBuilding->pStructureType))
 		{
@@ -1718,7 +1758,7 @@ STRUCTURE *buildStructureDir(STRUCTURE_STATS *pStructureType, UDWORD x, UDWORD y
 			//initialise the build points
 			psBuilding->currentBuildPts = 0;
 			//start building again
-			psBuilding->status = SS_BEING_BUILT;
+			setStructureStatus(psBuilding, SS_BEING_BUILT);
 			psBuilding->buildRate = 1;  // Don't abandon the structure first tick, so set to nonzero.
 			if (psBuilding->player == selectedPlayer && !FromSave)
 			{
@@ -2631,14 +2671,29 @@ static void aiUpdateStructure(STRUCTURE *psStructure, bool isMission)
 	/* See if there is an enemy to attack */
 	if (psStructure->numWeaps > 0)
 	{
-		//structures always update their targets
+		// Keep shooting at the current targets until it's time to look for better ones, unless a target was lost.
+		bool lostTarget = false;
+		for (i = 0; i < psStructure->numWeaps; i++)
+		{
+			if (psStructure->psTarget[i] != NULL && !aiStructCanKeepTarget(psStructure, i))
+			{
+				setStructureTarget(psStructure, NULL, i, ORIGIN_UNKNOWN);
+				lostTarget = true;
+			}
+		}
+		bool searchTargets = aiTargetSearchDue(psStructure, TARGET_SEARCH_INTERVAL, lostTarget);
+
 		for (i = 0; i < psStructure->numWeaps; i++)
 		{
 			bDirect = proj_Direct(asWeaponStats + psStructure->asWeaps[i].nStat);
 			if (psStructure->asWeaps[i].nStat > 0 &&
 			    asWeaponStats[psStructure->asWeaps[i].nStat].weaponSubClass != WSC_LAS_SAT)
 			{
-				if (aiChooseTarget(psStructure, &psChosenObjs[i], i, true, &tmpOrigin))
+				if (!searchTargets)
+				{
+					psChosenObjs[i] = psStructure->psTarget[i];
+				}
+				else if (aiChooseTarget(psStructure, &psChosenObjs[i], i, true, &tmpOrigin))
 				{
 					objTrace(psStructure->id, "Weapon %d is targeting %d at (%d, %d)", i, psChosenObjs[i]->id,
 					         psChosenObjs[i]->pos.x, psChosenObjs[i]->pos.y);
@@ -3770,6 +3825,18 @@ STRUCTURE::STRUCTURE(uint32_t id, unsigned player)
 	capacity = 0;
 }
 
+static WzPool structurePool("STRUCTURE", sizeof(STRUCTURE));
+
+void *STRUCTURE::operator new(size_t size)
+{
+	return structurePool.alloc(size);
+}
+
+void STRUCTURE::operator delete(void *ptr, size_t size)
+{
+	structurePool.free(ptr, size);
+}
+
 /* Release all resources associated with a structure */
 STRUCTURE::~STRUCTURE()
 {
@@ -4552,11 +4619,8 @@ bool removeStruct(STRUCTURE *psDel, bool bDestroy)
 		}
 	}
 
-	//subtract one from the structLimits list so can build another - don't allow to go less than zero!
-	if (asStructLimits[psDel->player][psDel->pStructureType - asStructureStats].currentQuantity)
-	{
-		asStructLimits[psDel->player][psDel->pStructureType - asStructureStats].currentQuantity--;
-	}
+	//subtract one from the structLimits list so can build another
+	countStructure(psDel, -1);
 
 	//if it is a factory - need to reset the factoryNumFlag
 	if (StructIsFactory(psDel))
@@ -4793,23 +4857,16 @@ bool  structureIdle(STRUCTURE *psBuilding)
 /*checks to see if any structure exists of a specified type with a specified status */
 bool checkStructureStatus(STRUCTURE_STATS *psStats, UDWORD player, UDWORD status)
 {
-	STRUCTURE	*psStructure;
-	bool		found = false;
+	ASSERT_OR_RETURN(false, player < MAX_PLAYERS, "Invalid player %u", player);
 
-	for (psStructure = apsStructLists[player]; psStructure != NULL;
-	     psStructure = psStructure->psNext)
+	// Structures in the lists are either being built or built.
+	uint32_t built = structTypeBuiltQuantity[player][psStats->type];
+	switch (status)
 	{
-		if (psStructure->pStructureType->type == psStats->type)
-		{
-			//need to check if THIS instance of the type has the correct status
-			if (psStructure->status == status)
-			{
-				found = true;
-				break;
-			}
-		}
+	case SS_BUILT: return built > 0;
+	case SS_BEING_BUILT: return structTypeQuantity[player][psStats->type] > built;
+	default: return false;
 	}
-	return found;
 }
 
 
@@ -4817,25 +4874,10 @@ bool checkStructureStatus(STRUCTURE_STATS *psStats, UDWORD player, UDWORD status
 stat type*/
 bool checkSpecificStructExists(UDWORD structInc, UDWORD player)
 {
-	STRUCTURE	*psStructure;
-	bool		found = false;
-
 	ASSERT_OR_RETURN(false, structInc < numStructureStats, "Invalid structure inc");
+	ASSERT_OR_RETURN(false, player < MAX_PLAYERS, "Invalid player %u", player);
 
-	for (psStructure = apsStructLists[player]; psStructure != NULL;
-	     psStructure = psStructure->psNext)
-	{
-		if (psStructure->status == SS_BUILT)
-		{
-			if ((psStructure->pStructureType->ref - REF_STRUCTURE_START) ==
-			    structInc)
-			{
-				found = true;
-				break;
-			}
-		}
-	}
-	return found;
+	return asStructLimits[player][structInc].builtQuantity > 0;
 }
 
 
@@ -5343,7 +5385,7 @@ void buildingComplete(STRUCTURE *psBuilding)
 	}
 
 	psBuilding->currentBuildPts = psBuilding->pStructureType->buildPoints;
-	psBuilding->status = SS_BUILT;
+	setStructureStatus(psBuilding, SS_BUILT);
 
 	visTilesUpdate(psBuilding);
 
@@ -6864,6 +6906,7 @@ STRUCTURE *giftSingleStructure(STRUCTURE *psStructure, UBYTE attackPlayer, bool
 
 			// add to other list.
 			addStructure(psStructure);
+			countStructure(psStructure, 1);
 
 			//check through the 'attackPlayer' players list of droids to see if any are targetting it
 			for (psCurr = apsDroidLists[attackPlayer]; psCurr != NULL; psCurr = psCurr->psNext)
@@ -6962,12 +7005,11 @@ STRUCTURE *giftSingleStructure(STRUCTURE *psStructure, UBYTE attackPlayer, bool
 		}
 		if (buildPoints)
 		{
-			psNewStruct->status = SS_BEING_BUILT;
+			setStructureStatus(psNewStruct, SS_BEING_BUILT);
 			psNewStruct->currentBuildPts = buildPoints;
 		}
 		else
 		{
-			psNewStruct->status = SS_BUILT;
 			buildingComplete(psNewStruct);
 			triggerEventStructBuilt(psStructure, NULL);
 		}
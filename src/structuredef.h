@@ -233,6 +233,9 @@ struct STRUCTURE : public BASE_OBJECT
 	STRUCTURE(uint32_t id, unsigned player);
 	~STRUCTURE();
 
+	static void *operator new(size_t size);            ///< Allocates from a WzPool.
+	static void operator delete(void *ptr, size_t size);
+
 	STRUCTURE_STATS     *pStructureType;            /* pointer to the structure stats for this type of building */
 	STRUCT_STATES       status;                     /* defines whether the structure is being built, doing nothing or performing a function */
 	uint32_t            currentBuildPts;            /* the build points currently assigned to this structure */
@@ -263,6 +266,7 @@ struct STRUCTURE_LIMITS
 {
 	uint32_t        limit;                  // the number allowed to be built
 	uint32_t        currentQuantity;        // the number of the type currently built per player
+	uint32_t        builtQuantity;          // the number of the type per player that are finished (SS_BUILT)
 	uint32_t        globalLimit;            // multiplayer only. sets the max value selectable (limits changed by player)
 };
 
@@ -23,6 +23,7 @@
  * Pumpkin Studios, Eidos Interactive 1996.
  */
 #include "lib/framework/frame.h"
+#include "lib/framework/wzparallel.h"
 
 #include "lib/gamelib/gtime.h"
 #include "lib/sound/audio.h"
@@ -37,6 +38,7 @@
 #include "geometry.h"
 #include "hci.h"
 #include "mapgrid.h"
+#include "pointtree.h"
 #include "cluster.h"
 #include "research.h"
 #include "scriptextern.h"
@@ -104,10 +106,11 @@ void visUpdateLevel(void)
 
 static inline void updateTileVis(MAPTILE *psTile)
 {
+	TILE_VISION const *psVision = tileVision(psTile);
 	for (int i = 0; i < MAX_PLAYERS; i++)
 	{
 		/// The definition of whether a player can see something on a given tile or not
-		if (psTile->watchers[i] > 0 || (psTile->sensors[i] > 0 && !(psTile->jammerBits & ~alliancebits[i])))
+		if (psVision->watchers[i] > 0 || (psVision->sensors[i] > 0 && !(psTile->jammerBits & ~alliancebits[i])))
 		{
 			psTile->sensorBits |= (1 << i);         // mark it as being seen
 		}
@@ -134,7 +137,7 @@ uint32_t addSpotter(int x, int y, int player, int radius, bool radar, uint32_t e
 		}
 		MAPTILE *psTile = mapTile(mapX, mapY);
 		psTile->tileExploredBits |= alliancebits[player];
-		uint8_t *visionType = (!radar) ? psTile->watchers : psTile->sensors;
+		uint8_t *visionType = (!radar) ? tileVision(psTile)->watchers : tileVision(psTile)->sensors;
 		if (visionType[player] < UBYTE_MAX)
 		{
 			TILEPOS tilePos = {uint8_t(mapX), uint8_t(mapY), uint8_t(radar)};
@@ -202,7 +205,7 @@ SPOTTER::~SPOTTER()
 	{
 		const TILEPOS pos = watchedTiles[i];
 		MAPTILE *psTile = mapTile(pos.x, pos.y);
-		uint8_t *visionType = (pos.type == 0) ? psTile->watchers : psTile->sensors;
+		uint8_t *visionType = (pos.type == 0) ? tileVision(psTile)->watchers : tileVision(psTile)->sensors;
 		ASSERT(visionType[player] > 0, "Not watching watched tile (%d, %d)", (int)pos.x, (int)pos.y);
 		visionType[player]--;
 		updateTileVis(psTile);
@@ -221,7 +224,8 @@ static inline void visMarkTile(const BASE_OBJECT *psObj, int mapX, int mapY, MAP
 	const int ydiff = map_coord(psObj->pos.y) - mapY;
 	const int distSq = xdiff * xdiff + ydiff * ydiff;
 	const bool inRange = (distSq < 16);
-	uint8_t *visionType = inRange ? psTile->watchers : psTile->sensors;
+	TILE_VISION *psVision = tileVision(psTile);
+	uint8_t *visionType = inRange ? psVision->watchers : psVision->sensors;
 
 	if (visionType[rayPlayer] < UBYTE_MAX && *lastRecordTilePos < MAX_SEEN_TILES)
 	{
@@ -230,7 +234,7 @@ static inline void visMarkTile(const BASE_OBJECT *psObj, int mapX, int mapY, MAP
 		visionType[rayPlayer]++;                        // we observe this tile
 		if (psObj->jammedTiles)                         // we are a jammer object
 		{
-			psTile->jammers[rayPlayer]++;
+			psVision->jammers[rayPlayer]++;
 			psTile->jammerBits |= (1 << rayPlayer); // mark it as being jammed
 		}
 		updateTileVis(psTile);
@@ -239,16 +243,15 @@ static inline void visMarkTile(const BASE_OBJECT *psObj, int mapX, int mapY, MAP
 	}
 }
 
-/* The terrain revealing ray callback */
-static void doWaveTerrain(const BASE_OBJECT *psObj, TILEPOS *recordTilePos, int *lastRecordTilePos)
+/* The terrain revealing ray callback. Finds the tiles the object can see, without changing anything, so can be called from several threads at once. */
+static void doWaveTerrain(const BASE_OBJECT *psObj, std::vector<TILEPOS> &seenTiles)
 {
 	const int sx = psObj->pos.x;
 	const int sy = psObj->pos.y;
 	const int sz = psObj->pos.z + MAX(MIN_VIS_HEIGHT, psObj->sDisplay.imd->max.y);
 	const unsigned radius = objSensorRange(psObj);
-	const int rayPlayer = psObj->player;
 	size_t size;
-	const WavecastTile *tiles = getWavecastTable(radius, &size);
+	const WavecastTile *tiles = getWavecastTable(radius, &size);  // Must already have been generated, if on another thread.
 #define MAX_WAVECAST_LIST_SIZE 1360  // Trivial upper bound to what a fully upgraded WSS can use (its number of angles). Should probably be some factor times the maximum possible radius. Is probably a lot more than needed. Tested to need at least 180.
 	int heights[2][MAX_WAVECAST_LIST_SIZE];
 	int angles[2][MAX_WAVECAST_LIST_SIZE + 1];
@@ -316,10 +319,55 @@ static void doWaveTerrain(const BASE_OBJECT *psObj, TILEPOS *recordTilePos, int
 		if (seen)
 		{
 			// Can see this tile.
-			psTile->tileExploredBits |= alliancebits[rayPlayer];                        // Share exploration with allies too
-			visMarkTile(psObj, mapX, mapY, psTile, recordTilePos, lastRecordTilePos);   // Mark this tile as seen by our sensor
+			TILEPOS tilePos = {uint8_t(mapX), uint8_t(mapY), 0};
+			seenTiles.push_back(tilePos);
+		}
+	}
+}
+
+/// Makes psObj->wavecastCache hold the tiles psObj can see, only doing the wavecast again if the object moved to another tile,
+/// its sensor changed, or the terrain it can see changed height.
+static void doWaveTerrainCached(BASE_OBJECT *psObj)
+{
+	const Vector2i tile = map_coord(psObj->pos.xy);
+	const int height = psObj->pos.z + MAX(MIN_VIS_HEIGHT, psObj->sDisplay.imd->max.y);
+	const unsigned radius = objSensorRange(psObj);
+	const int reach = map_coord(radius) + 1;  // The wavecast looks at tiles up to this far away.
+
+	WavecastCache *cache = psObj->wavecastCache;
+	if (cache != NULL && cache->auxGeneration == auxMapGeneration && cache->tile == tile && cache->height == height && cache->radius == radius
+	    && !mapHeightChangedSince(cache->heightChanges, tile.x - reach, tile.y - reach, tile.x + reach, tile.y + reach))
+	{
+		return;  // Would see the same as last time.
+	}
+
+	if (cache == NULL)
+	{
+		cache = psObj->wavecastCache = new WavecastCache;
+	}
+	cache->auxGeneration = auxMapGeneration;
+	cache->heightChanges = mapHeightChanges;
+	cache->tile = tile;
+	cache->height = height;
+	cache->radius = radius;
+	cache->seenTiles.clear();
+	doWaveTerrain(psObj, cache->seenTiles);
+}
+
+/// Whether the object confers visibility to the tiles it can see.
+static bool objSeesTiles(const BASE_OBJECT *psObj)
+{
+	if (psObj->type == OBJ_STRUCTURE)
+	{
+		const STRUCTURE *psStruct = (const STRUCTURE *)psObj;
+		if (psStruct->status != SS_BUILT ||
+		    psStruct->pStructureType->type == REF_WALL || psStruct->pStructureType->type == REF_WALLCORNER || psStruct->pStructureType->type == REF_GATE)
+		{
+			// unbuilt structures and walls do not confer visibility.
+			return false;
 		}
 	}
+	return true;
 }
 
 /* Remove tile visibility from object */
@@ -332,9 +380,10 @@ void visRemoveVisibility(BASE_OBJECT *psObj)
 			const TILEPOS pos = psObj->watchedTiles[i];
 			// FIXME: the mapTile might have been swapped out, see swapMissionPointers()
 			MAPTILE *psTile = mapTile(pos.x, pos.y);
+			TILE_VISION *psVision = tileVision(psTile);
 
 			ASSERT(pos.type < 2, "Invalid visibility type %d", (int)pos.type);
-			uint8_t *visionType = (pos.type == 0) ? psTile->sensors : psTile->watchers;
+			uint8_t *visionType = (pos.type == 0) ? psVision->sensors : psVision->watchers;
 			if (visionType[psObj->player] == 0 && game.type == CAMPAIGN)	// hack
 			{
 				continue;
@@ -344,9 +393,9 @@ void visRemoveVisibility(BASE_OBJECT *psObj)
 			if (psObj->jammedTiles)  // we are a jammer object — we cannot check objJammerPower(psObj) > 0 directly here, we may be in the BASE_OBJECT destructor).
 			{
 				// No jammers in campaign, no need for special hack
-				ASSERT(psTile->jammers[psObj->player] > 0, "Not jamming watched tile (%d, %d)", (int)pos.x, (int)pos.y);
-				psTile->jammers[psObj->player]--;
-				if (psTile->jammers[psObj->player] == 0)
+				ASSERT(psVision->jammers[psObj->player] > 0, "Not jamming watched tile (%d, %d)", (int)pos.x, (int)pos.y);
+				psVision->jammers[psObj->player]--;
+				if (psVision->jammers[psObj->player] == 0)
 				{
 					psTile->jammerBits &= ~(1 << psObj->player);
 				}
@@ -367,31 +416,27 @@ void visRemoveVisibilityOffWorld(BASE_OBJECT *psObj)
 	psObj->numWatchedTiles = 0;
 }
 
-/* Check which tiles can be seen by an object */
-void visTilesUpdate(BASE_OBJECT *psObj)
+/* Replace the map visibility provided by an object with the tiles found by doWaveTerrain */
+static void visTilesSet(BASE_OBJECT *psObj, std::vector<TILEPOS> const &seenTiles)
 {
 	TILEPOS recordTilePos[MAX_SEEN_TILES];
 	int lastRecordTilePos = 0;
 
-	ASSERT(psObj->type != OBJ_FEATURE, "visTilesUpdate: visibility updates are not for features!");
-
 	// Remove previous map visibility provided by object
 	visRemoveVisibility(psObj);
 
-	if (psObj->type == OBJ_STRUCTURE)
+	if (!objSeesTiles(psObj))
 	{
-		STRUCTURE *psStruct = (STRUCTURE *)psObj;
-		if (psStruct->status != SS_BUILT ||
-		    psStruct->pStructureType->type == REF_WALL || psStruct->pStructureType->type == REF_WALLCORNER || psStruct->pStructureType->type == REF_GATE)
-		{
-			// unbuilt structures and walls do not confer visibility.
-			return;
-		}
+		return;
 	}
 
-	// Do the whole circle in ∞ steps. No more pretty moiré patterns.
 	psObj->jammedTiles = objJammerPower(psObj) > 0;
-	doWaveTerrain(psObj, recordTilePos, &lastRecordTilePos);
+	for (unsigned i = 0; i < seenTiles.size(); ++i)
+	{
+		MAPTILE *psTile = mapTile(seenTiles[i].x, seenTiles[i].y);
+		psTile->tileExploredBits |= alliancebits[psObj->player];                                     // Share exploration with allies too
+		visMarkTile(psObj, seenTiles[i].x, seenTiles[i].y, psTile, recordTilePos, &lastRecordTilePos);  // Mark this tile as seen by our sensor
+	}
 
 	// Record new map visibility provided by object
 	if (lastRecordTilePos > 0)
@@ -402,6 +447,66 @@ void visTilesUpdate(BASE_OBJECT *psObj)
 	}
 }
 
+/* Check which tiles can be seen by an object */
+void visTilesUpdate(BASE_OBJECT *psObj)
+{
+	static const std::vector<TILEPOS> noTiles;
+
+	ASSERT(psObj->type != OBJ_FEATURE, "visTilesUpdate: visibility updates are not for features!");
+
+	psObj->flags &= ~BASEFLAG_VISTILES;  // Not needed later, if visTilesUpdateLater() was called.
+
+	// Do the whole circle in ∞ steps. No more pretty moiré patterns.
+	if (!objSeesTiles(psObj))
+	{
+		visTilesSet(psObj, noTiles);
+		return;
+	}
+	doWaveTerrainCached(psObj);
+	visTilesSet(psObj, psObj->wavecastCache->seenTiles);
+}
+
+void visTilesUpdateLater(DROID *psDroid)
+{
+	psDroid->flags |= BASEFLAG_VISTILES;
+}
+
+/* Do the visTilesUpdate()s asked for with visTilesUpdateLater(). The wavecasts are done by several threads, and the
+ * results are then put on the map in the order of the droid lists, so that the tile counts come out the same on all clients. */
+static void processVisibilityTiles()
+{
+	static std::vector<BASE_OBJECT *> objects;  // static to avoid allocations.
+
+	objects.clear();
+	for (int player = 0; player < MAX_PLAYERS; ++player)
+	{
+		for (DROID *psDroid = apsDroidLists[player]; psDroid != NULL; psDroid = psDroid->psNext)
+		{
+			if ((psDroid->flags & BASEFLAG_VISTILES) != 0)
+			{
+				psDroid->flags &= ~BASEFLAG_VISTILES;
+				if (!psDroid->died)
+				{
+					size_t size;
+					getWavecastTable(objSensorRange(psDroid), &size);  // Generate the table now, since that isn't thread safe.
+					objects.push_back(psDroid);
+				}
+			}
+		}
+	}
+	wzParallelFor(objects.size(), [](unsigned begin, unsigned end, unsigned) {
+		for (unsigned i = begin; i < end; ++i)
+		{
+			doWaveTerrainCached(objects[i]);
+		}
+	});
+
+	for (unsigned i = 0; i < objects.size(); ++i)
+	{
+		visTilesSet(objects[i], objects[i]->wavecastCache->seenTiles);
+	}
+}
+
 /*reveals all the terrain in the map*/
 void revealAll(UBYTE player)
 {
@@ -493,6 +598,7 @@ int visibleObject(const BASE_OBJECT *psViewer, const BASE_OBJECT *psTarget, bool
 	}
 
 	MAPTILE *psTile = mapTile(map_coord(psTarget->pos.x), map_coord(psTarget->pos.y));
+	TILE_VISION const *psVision = tileVision(psTile);
 	bool jammed = psTile->jammerBits & ~alliancebits[psViewer->player];
 
 	// Special rule for VTOLs, as they are not affected by ECM
@@ -503,12 +609,12 @@ int visibleObject(const BASE_OBJECT *psViewer, const BASE_OBJECT *psTarget, bool
 		return UBYTE_MAX;
 	}
 	// Show objects hidden by ECM jamming with radar blips
-	else if (psTile->watchers[psViewer->player] == 0 && psTile->sensors[psViewer->player] > 0 && jammed)
+	else if (psVision->watchers[psViewer->player] == 0 && psVision->sensors[psViewer->player] > 0 && jammed)
 	{
 		return UBYTE_MAX / 2;
 	}
 	// Show objects that are seen directly or with unjammed sensors
-	else if (psTile->watchers[psViewer->player] > 0 || (psTile->sensors[psViewer->player] > 0 && !jammed))
+	else if (psVision->watchers[psViewer->player] > 0 || (psVision->sensors[psViewer->player] > 0 && !jammed))
 	{
 		return UBYTE_MAX;
 	}
@@ -632,26 +738,52 @@ static void processVisibilitySelf(BASE_OBJECT *psObj)
 	}
 }
 
-// Calculate which objects we can see. Better to call after processVisibilitySelf, since that check is cheaper.
-static void processVisibilityVision(BASE_OBJECT *psViewer)
+struct VisibilitySeen
+{
+	BASE_OBJECT *psObj;
+	int val;
+};
+
+static std::vector<BASE_OBJECT *> visionViewers;
+static std::vector<std::vector<VisibilitySeen>> visionSeen;  ///< What each of visionViewers can see.
+static std::vector<GridQuery> visionGridQueries;             ///< One for each thread.
+
+// Find the objects each viewer can see. Only reads, so can be called from several threads at once. Better to call after processVisibilitySelf, since that check is cheaper.
+static void processVisibilityVisionFind(unsigned begin, unsigned end, unsigned thread)
 {
-	if (psViewer->type == OBJ_FEATURE)
+	GridQuery &gridQuery = visionGridQueries[thread];
+	for (unsigned i = begin; i < end; ++i)
 	{
-		return;
+		BASE_OBJECT *psViewer = visionViewers[i];
+		std::vector<VisibilitySeen> &seen = visionSeen[i];
+		seen.clear();
+
+		// get all the objects from the grid the droid is in, that aren't already fully seen by processVisibilitySelf
+		GridList const &gridList = gridQuery.findUnseen(psViewer->pos.x, psViewer->pos.y, objSensorRange(psViewer), psViewer->player);
+		for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
+		{
+			BASE_OBJECT *psObj = *gi;
+			int val = visibleObject(psViewer, psObj, false);
+			if (val > 0)
+			{
+				VisibilitySeen objSeen = {psObj, val};
+				seen.push_back(objSeen);
+			}
+		}
 	}
+}
 
-	// get all the objects from the grid the droid is in
+// Calculate which objects we can see, from the results of processVisibilityVisionFind.
+static void processVisibilityVision(BASE_OBJECT *psViewer, std::vector<VisibilitySeen> const &seen)
+{
 	// Will give inconsistent results if hasSharedVision is not an equivalence relation.
-	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterateUnseen(psViewer->pos.x, psViewer->pos.y, objSensorRange(psViewer), psViewer->player);
-	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
+	for (unsigned i = 0; i < seen.size(); ++i)
 	{
-		BASE_OBJECT *psObj = *gi;
+		BASE_OBJECT *psObj = seen[i].psObj;
+		int val = seen[i].val;
 
-		int val = visibleObject(psViewer, psObj, false);
-
-		// If we've got ranged line of sight...
-		if (val > 0)
+		// Skip objects already fully seen by an earlier viewer, as gridStartIterateUnseen would.
+		if (psObj->seenThisTick[psViewer->player] < UBYTE_MAX)
 		{
 			// Tell system that this side can see this object
 			setSeenBy(psObj, psViewer->player, val);
@@ -669,6 +801,47 @@ static void processVisibilityVision(BASE_OBJECT *psViewer)
 	}
 }
 
+// Show active radars within range of radar detectors as radar blips.
+static void processVisibilityRadarDetectors()
+{
+	static PointTree activeRadars;  // static to avoid allocations.
+	static PointTree::ResultVector targets;
+	bool anyDetectors = false;
+
+	activeRadars.clear();
+	for (BASE_OBJECT *psObj = apsSensorList[0]; psObj != NULL; psObj = psObj->psNextFunc)
+	{
+		if (objActiveRadar(psObj))
+		{
+			activeRadars.insert(psObj, psObj->pos.x, psObj->pos.y);
+		}
+		anyDetectors = anyDetectors || objRadarDetector(psObj);
+	}
+	if (!anyDetectors)
+	{
+		return;
+	}
+	activeRadars.sort();
+
+	for (BASE_OBJECT *psObj = apsSensorList[0]; psObj != NULL; psObj = psObj->psNextFunc)
+	{
+		if (objRadarDetector(psObj))
+		{
+			int range = objSensorRange(psObj) * 10;
+			activeRadars.query(targets, psObj->pos.x, psObj->pos.y, range);
+			for (unsigned i = 0; i < targets.size(); ++i)
+			{
+				BASE_OBJECT *psTarget = static_cast<BASE_OBJECT *>(targets[i]);
+				if (psObj != psTarget && psTarget->visible[psObj->player] < UBYTE_MAX / 2
+				    && iHypot((psTarget->pos - psObj->pos).xy) < range)
+				{
+					psTarget->visible[psObj->player] = UBYTE_MAX / 2;
+				}
+			}
+		}
+	}
+}
+
 /* Find out what can see this object */
 // Fade in/out of view. Must be called after calculation of which objects are seen.
 static void processVisibilityLevel(BASE_OBJECT *psObj)
@@ -749,6 +922,7 @@ static void processVisibilityLevel(BASE_OBJECT *psObj)
 
 void processVisibility()
 {
+	processVisibilityTiles();
 	updateSpotters();
 	for (int player = 0; player < MAX_PLAYERS; ++player)
 	{
@@ -762,6 +936,9 @@ void processVisibility()
 			}
 		}
 	}
+
+	// Find what each object can see on several threads, then use the results in the order of the object lists.
+	visionViewers.clear();
 	for (int player = 0; player < MAX_PLAYERS; ++player)
 	{
 		BASE_OBJECT *lists[] = {apsDroidLists[player], apsStructLists[player]};
@@ -770,25 +947,21 @@ void processVisibility()
 		{
 			for (BASE_OBJECT *psObj = lists[list]; psObj != NULL; psObj = psObj->psNext)
 			{
-				processVisibilityVision(psObj);
+				visionViewers.push_back(psObj);
 			}
 		}
 	}
-	for (BASE_OBJECT *psObj = apsSensorList[0]; psObj != NULL; psObj = psObj->psNextFunc)
+	if (visionSeen.size() < visionViewers.size())
 	{
-		if (objRadarDetector(psObj))
-		{
-			for (BASE_OBJECT *psTarget = apsSensorList[0]; psTarget != NULL; psTarget = psTarget->psNextFunc)
-			{
-				if (psObj != psTarget && psTarget->visible[psObj->player] < UBYTE_MAX / 2
-				    && objActiveRadar(psTarget)
-				    && iHypot((psTarget->pos - psObj->pos).xy) < objSensorRange(psObj) * 10)
-				{
-					psTarget->visible[psObj->player] = UBYTE_MAX / 2;
-				}
-			}
-		}
+		visionSeen.resize(visionViewers.size());
+	}
+	visionGridQueries.resize(wzParallelThreadCount());
+	wzParallelFor(visionViewers.size(), processVisibilityVisionFind);
+	for (unsigned i = 0; i < visionViewers.size(); ++i)
+	{
+		processVisibilityVision(visionViewers[i], visionSeen[i]);
 	}
+	processVisibilityRadarDetectors();
 	for (int player = 0; player < MAX_PLAYERS; ++player)
 	{
 		BASE_OBJECT *lists[] = {apsDroidLists[player], apsStructLists[player], apsFeatureLists[player]};
@@ -25,13 +25,29 @@
 #include "raycast.h"
 #include "stats.h"
 
+#include <vector>
+
 #define LINE_OF_FIRE_MINIMUM 5
 
+/// The tiles an object saw the last time it did a wavecast, and what they depended on, so that the
+/// wavecast needn't be done again while the object stays on the same tile.
+struct WavecastCache
+{
+	uint32_t auxGeneration;         ///< auxMapGeneration, which changes when the map is replaced.
+	uint32_t heightChanges;         ///< mapHeightChanges.
+	Vector2i tile;                  ///< Tile the object was on.
+	int height;                     ///< Height the object was looking from.
+	unsigned radius;                ///< Sensor range.
+	std::vector<TILEPOS> seenTiles;
+};
+
 // initialise the visibility stuff
 extern bool visInitialise(void);
 
 /* Check which tiles can be seen by an object */
 extern void visTilesUpdate(BASE_OBJECT *psObj);
+/// Same as visTilesUpdate(), but done at the start of the next processVisibility(), where the tiles seen by all moved droids are found on several threads at once.
+void visTilesUpdateLater(DROID *psDroid);
 
 extern void revealAll(UBYTE player);
 
@@ -41,6 +41,9 @@ struct WARZONE_GLOBALS
 	int8_t SPcolor = 0;
 	int MPcolour = -1;
 	int antialiasing = 0;
+	int pathThreads = 0;
+	int workerThreads = 0;
+	int replayKeep = 0;
 	bool Fullscreen = false;
 	bool soundEnabled = true;
 	bool trapCursor = false;
@@ -104,6 +107,36 @@ int war_getAntialiasing()
 	return warGlobs.antialiasing;
 }
 
+void war_setPathThreads(int threads)
+{
+	warGlobs.pathThreads = threads;
+}
+
+int war_getPathThreads()
+{
+	return warGlobs.pathThreads;
+}
+
+void war_setWorkerThreads(int threads)
+{
+	warGlobs.workerThreads = threads;
+}
+
+int war_getWorkerThreads()
+{
+	return warGlobs.workerThreads;
+}
+
+void war_setReplayKeep(int count)
+{
+	warGlobs.replayKeep = count;
+}
+
+int war_getReplayKeep()
+{
+	return warGlobs.replayKeep;
+}
+
 void war_SetTrapCursor(bool b)
 {
 	warGlobs.trapCursor = b;
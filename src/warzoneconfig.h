@@ -76,6 +76,12 @@ void war_setMPcolour(int colour);
 int war_getMPcolour();
 void war_setScanlineMode(SCANLINE_MODE mode);
 SCANLINE_MODE war_getScanlineMode(void);
+void war_setPathThreads(int threads);
+int war_getPathThreads();  ///< Number of path finding threads, 0 means one less than the number of CPU cores.
+void war_setWorkerThreads(int threads);
+int war_getWorkerThreads();  ///< Number of threads helping with the game update, 0 means one less than the number of CPU cores.
+void war_setReplayKeep(int count);
+int war_getReplayKeep();  ///< Number of recent replays to keep, 0 means games are not recorded.
 
 /**
  * Enable or disable sound initialization
@@ -325,6 +325,11 @@ void loadingScreenCallback(void)
 // fill buffers with the static screen
 void initLoadingScreen(bool drawbdrop)
 {
+	if (pie_Headless())
+	{
+		return;  // Nothing to show it on.
+	}
+
 	setupLoadingScreen();
 	wzShowMouse(false);
 	pie_SetFogStatus(false);
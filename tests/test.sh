@@ -15,7 +15,11 @@ function run
 	echo
 	echo " -- $2 --"
 	echo
-	gdb -q --ex run --ex quit --args src/warzone2100 --window --configdir=tmp --resolution=1024x768 --shadows --sound --texturecompression $1
+	if [ -n "$HEADLESS" ]; then
+		src/warzone2100 --headless --configdir=tmp $1 || exit 1
+	else
+		gdb -q --ex run --ex quit --args src/warzone2100 --window --configdir=tmp --resolution=1024x768 --shadows --sound --texturecompression $1
+	fi
 }
 
 function cam